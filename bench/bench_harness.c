@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "bench_harness.h"
+#include "macros.h"
+#include "utils.h"
+
+// Usage: paroliere_bench [--repeat n] [--threshold fraction] [--save file] [--compare file] [name_filter]
+void parse_bench_options(int argc, char* argv[], BenchOptions* options) {
+    options->filter = NULL;
+    options->repeat = BENCH_DEFAULT_REPEAT;
+    options->threshold = BENCH_DEFAULT_THRESHOLD;
+    options->save_file = NULL;
+    options->compare_file = NULL;
+
+    static struct option long_opts[] = {
+        {"repeat",    required_argument, NULL, 'r'},
+        {"threshold", required_argument, NULL, 't'},
+        {"save",      required_argument, NULL, 's'},
+        {"compare",   required_argument, NULL, 'c'},
+        {0, 0, 0, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "r:t:s:c:", long_opts, NULL)) != -1) {
+        switch (option) {
+            case 'r': options->repeat = atoi(optarg); break;
+            case 't': options->threshold = atof(optarg); break;
+            case 's': options->save_file = optarg; break;
+            case 'c': options->compare_file = optarg; break;
+            default: handle_error(WRONG_PARAMS_ERROR);
+        }
+    }
+    if (optind < argc) {
+        options->filter = argv[optind];
+    }
+
+    if (options->repeat <= 0 || options->threshold < 0) {
+        handle_error(NEGATIVE_PARAM_ERROR);
+    }
+}
+
+static long long now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Doubling the iterations until one sample runs long enough to be timed reliably, this also warms up the kernel
+static long calibrate(const Benchmark* benchmark) {
+    long iterations = 1;
+    while (1) {
+        long long start = now_ns();
+        benchmark->run(iterations);
+        if (now_ns() - start >= BENCH_SAMPLE_NS) return iterations;
+        iterations *= 2;
+    }
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double value_a = *(const double*)a;
+    double value_b = *(const double*)b;
+    return (value_a > value_b) - (value_a < value_b);
+}
+
+// Loading a baseline file, returns the number of entries or -1 if it can't be opened
+static int load_baseline(const char* filename, BaselineEntry* entries) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return -1;
+
+    char line[256];
+    int count = 0;
+    while (fgets(line, sizeof(line), file) && count < BENCH_MAX_BENCHMARKS) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        BaselineEntry* entry = &entries[count];
+        entry->threshold = BENCH_DEFAULT_THRESHOLD;
+        if (sscanf(line, "%63s %lf %lf %lf", entry->name, &entry->median_ns, &entry->spread, &entry->threshold) >= 3) {
+            count++;
+        }
+    }
+
+    fclose(file);
+    return count;
+}
+
+static const BaselineEntry* find_baseline(const BaselineEntry* entries, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].name, name) == 0) return &entries[i];
+    }
+    return NULL;
+}
+
+// A benchmark regresses when its median is slower than the baseline by more than its threshold
+// plus half of the larger relative spread of the two runs, so noisy kernels need a bigger shift to fail.
+static bool is_regression(const BaselineEntry* baseline, double median_ns, double spread) {
+    double noise = (baseline->spread > spread ? baseline->spread : spread) / 2;
+    return median_ns > baseline->median_ns * (1 + baseline->threshold + noise);
+}
+
+static void save_baseline(const char* filename, const BaselineEntry* results, int count, const BaselineEntry* previous, int previous_count) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+
+    fprintf(file, "# benchmark median_ns spread threshold\n");
+    for (int i = 0; i < count; i++) {
+        // Keeping thresholds tuned by hand in the previous baseline
+        const BaselineEntry* old = find_baseline(previous, previous_count, results[i].name);
+        fprintf(file, "%s %.1f %.4f %.2f\n", results[i].name, results[i].median_ns, results[i].spread,
+                old ? old->threshold : results[i].threshold);
+    }
+
+    fclose(file);
+}
+
+int run_benchmarks(const Benchmark* benchmarks, int count, const BenchOptions* options, FILE* report) {
+    BaselineEntry baseline[BENCH_MAX_BENCHMARKS];
+    int baseline_count = 0;
+    if (options->compare_file) {
+        baseline_count = load_baseline(options->compare_file, baseline);
+        if (baseline_count < 0) {
+            fprintf(stderr, "Baseline file '%s' not found, record one first\n", options->compare_file);
+            return 2;
+        }
+    } else if (options->save_file) {
+        baseline_count = load_baseline(options->save_file, baseline);
+        if (baseline_count < 0) baseline_count = 0;
+    }
+
+    BaselineEntry results[BENCH_MAX_BENCHMARKS];
+    int result_count = 0;
+    int regressions = 0;
+    double* samples = malloc(options->repeat * sizeof(double));
+    if (!samples) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+
+    fprintf(report, "%-24s %12s %12s %14s %8s", "benchmark", "iterations", "ns/op", "ops/sec", "spread");
+    if (options->compare_file) fprintf(report, " %12s %8s  %s", "baseline", "change", "verdict");
+    fprintf(report, "\n");
+
+    for (int i = 0; i < count && result_count < BENCH_MAX_BENCHMARKS; i++) {
+        const Benchmark* benchmark = &benchmarks[i];
+        if (options->filter && !strstr(benchmark->name, options->filter)) continue;
+
+        long iterations = calibrate(benchmark);
+        for (int sample = 0; sample < options->repeat; sample++) {
+            long long start = now_ns();
+            benchmark->run(iterations);
+            samples[sample] = (double)(now_ns() - start) / iterations;
+        }
+        qsort(samples, options->repeat, sizeof(double), compare_doubles);
+
+        BaselineEntry* result = &results[result_count++];
+        snprintf(result->name, sizeof(result->name), "%s", benchmark->name);
+        result->median_ns = samples[options->repeat / 2];
+        result->spread = (samples[options->repeat - 1] - samples[0]) / result->median_ns;
+        result->threshold = options->threshold;
+
+        fprintf(report, "%-24s %12ld %12.1f %14.0f %7.1f%%", result->name, iterations, result->median_ns,
+                1e9 / result->median_ns, result->spread * 100);
+
+        if (options->compare_file) {
+            const BaselineEntry* old = find_baseline(baseline, baseline_count, result->name);
+            if (!old) {
+                fprintf(report, " %12s %8s  new", "-", "-");
+            } else {
+                bool regressed = is_regression(old, result->median_ns, result->spread);
+                double change = (result->median_ns - old->median_ns) / old->median_ns;
+                regressions += regressed;
+                fprintf(report, " %12.1f %+7.1f%%  %s", old->median_ns, change * 100,
+                        regressed ? "REGRESSION" : (change < -old->threshold ? "improved" : "ok"));
+            }
+        }
+        fprintf(report, "\n");
+        fflush(report);
+    }
+
+    free(samples);
+
+    if (options->save_file) {
+        save_baseline(options->save_file, results, result_count, baseline, baseline_count);
+        fprintf(report, "Baseline saved to %s\n", options->save_file);
+    }
+    if (options->compare_file) {
+        fprintf(report, "%d regression(s) against %s\n", regressions, options->compare_file);
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
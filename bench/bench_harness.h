@@ -0,0 +1,39 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define BENCH_SAMPLE_NS 100000000LL // Minimum duration of one timed sample
+#define BENCH_DEFAULT_REPEAT 5
+#define BENCH_DEFAULT_THRESHOLD 0.10 // Allowed slowdown over the baseline median, 0.10 = 10%
+#define BENCH_MAX_BENCHMARKS 64
+#define BENCH_MAX_NAME_LENGTH 64
+
+// A kernel runs its operation `iterations` times, the harness decides how many
+typedef struct {
+    const char* name;
+    void (*run)(long iterations);
+} Benchmark;
+
+typedef struct {
+    const char* filter;       // Only benchmarks whose name contains it, NULL for all
+    int repeat;               // Timed samples per benchmark, the median is reported
+    double threshold;         // Default per-benchmark threshold for new baseline entries
+    const char* save_file;    // Baseline to write, NULL to skip
+    const char* compare_file; // Baseline to compare against, NULL to skip
+} BenchOptions;
+
+// One line of a baseline file: name median_ns spread threshold
+typedef struct {
+    char name[BENCH_MAX_NAME_LENGTH];
+    double median_ns;
+    double spread;
+    double threshold;
+} BaselineEntry;
+
+void parse_bench_options(int argc, char* argv[], BenchOptions* options);
+// Returns the process exit code: 0 when no benchmark regressed against the baseline
+int run_benchmarks(const Benchmark* benchmarks, int count, const BenchOptions* options, FILE* report);
+
+#endif
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "protocol.h"
+#include "frame_reader.h"
+#include "renderer.h"
+#include "matrix_handler.h"
+#include "macros.h"
+#include "utils.h"
+#include "bench_harness.h"
+
+// Microbenchmarks for the client hot paths, linked against the client objects.
+// Usage (from the client directory): ./executables/paroliere_bench [--repeat n] [--save file] [--compare file] [name_filter]
+
+#define INPUT_COUNT 1024 // Power of two, inputs are picked with i & INPUT_MASK
+#define INPUT_MASK (INPUT_COUNT - 1)
+#define BENCH_SEED 42
+#define READ_BATCH 256 // Frames written to the pipe at once, well below its capacity
+#define REPLY_FRAME_SIZE (sizeof(int) + sizeof(char) + sizeof(int) + 2)
+
+// Inputs shared by the kernels, built once before timing anything
+static Message word_messages[INPUT_COUNT];
+static char word_data[INPUT_COUNT][MAX_WORD_LENGTH + 1];
+static char score_frames[INPUT_COUNT][sizeof(char) + sizeof(int) + 4];
+static char matrix_frame[sizeof(char) + sizeof(int) + MATRIX_BYTES];
+static Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
+static char reply_stream[READ_BATCH * REPLY_FRAME_SIZE]; // Length-prefixed word replies, as the server sends them
+static int reply_pipe[2];
+static FrameReader pipe_reader;
+static char screen_frames[2][RENDER_FRAME_SIZE]; // The same screen one second of countdown apart
+static size_t screen_frame_lengths[2];
+static Screen screen;
+static char render_output[RENDER_OUTPUT_SIZE];
+
+static volatile long sink; // Keeps the compiler from dropping the kernels' results
+static FILE* report;
+
+static void bench_pack_message(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        char* buffer;
+        sink += pack_message(&word_messages[i & INPUT_MASK], &buffer);
+        free(buffer);
+    }
+}
+
+static void bench_interpret_word_reply(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        Message message = interpret_message(score_frames[i & INPUT_MASK]);
+        sink += message.size;
+        free(message.data);
+    }
+}
+
+static void bench_interpret_matrix(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        Message message = interpret_message(matrix_frame);
+        sink += message.size;
+        free(message.data);
+    }
+}
+
+// Reading the replies back through a pipe, one frame per iteration, without copying them out of the buffer
+static void bench_read_frames(long iterations) {
+    for (long done = 0; done < iterations;) {
+        long batch = iterations - done < READ_BATCH ? iterations - done : READ_BATCH;
+        if (write(reply_pipe[1], reply_stream, batch * REPLY_FRAME_SIZE) == -1) {
+            handle_error(FILE_OPEN_ERROR);
+        }
+        Message message;
+        for (long received = 0; received < batch;) {
+            if (frame_reader_next(&pipe_reader, &message) == 1) {
+                sink += message.size;
+                received++;
+            } else {
+                frame_reader_fill(&pipe_reader);
+            }
+        }
+        done += batch;
+    }
+}
+
+static void bench_print_matrix(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        print_matrix(matrix);
+    }
+    fflush(stdout);
+}
+
+static void bench_trace_word(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        sink += can_trace_word(matrix, word_data[i & INPUT_MASK]);
+    }
+}
+
+// Diffing a countdown tick against the previous screen, the usual update during a game
+static void bench_render_time_update(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        int frame = i & 1;
+        sink += screen_diff(&screen, screen_frames[frame], screen_frame_lengths[frame], false, render_output, sizeof(render_output));
+    }
+}
+
+static const Benchmark benchmarks[] = {
+    { "pack_message", bench_pack_message },
+    { "interpret_word_reply", bench_interpret_word_reply },
+    { "interpret_matrix", bench_interpret_matrix },
+    { "read_frames", bench_read_frames },
+    { "trace_word", bench_trace_word },
+    { "print_matrix", bench_print_matrix },
+    { "render_time_update", bench_render_time_update },
+};
+
+// The rendering code writes on stdout, results go to a copy of the original stdout instead
+static void redirect_stdout() {
+    fflush(stdout);
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (!report || devnull == -1) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+}
+
+static void write_frame(char* frame, char type, const void* data, int size) {
+    frame[0] = type;
+    memcpy(frame + sizeof(char), &size, sizeof(int));
+    memcpy(frame + sizeof(char) + sizeof(int), data, size);
+}
+
+static void prepare_inputs() {
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        int length = 4 + rand() % 7;
+        for (int j = 0; j < length; j++) {
+            word_data[i][j] = 'a' + rand() % 26;
+        }
+        word_data[i][length] = '\0';
+        word_messages[i].type = MSG_PAROLA;
+        word_messages[i].size = length;
+        word_messages[i].data = word_data[i];
+
+        char points[4];
+        int points_length = snprintf(points, sizeof(points), "%d", rand() % 12 - 1);
+        write_frame(score_frames[i], MSG_PUNTI_PAROLA, points, points_length);
+    }
+
+    static const char* letters = "ABCDEFGHILMNOPRSTUVZ";
+    for (int i = 0; i < MATRIX_SIZE; i++) {
+        for (int j = 0; j < MATRIX_SIZE; j++) {
+            matrix[i][j].letter[0] = letters[rand() % strlen(letters)];
+            matrix[i][j].letter[1] = '\0';
+        }
+    }
+    strcpy(matrix[1][2].letter, "Qu");
+    write_frame(matrix_frame, MSG_MATRICE, matrix, MATRIX_BYTES);
+
+    int frame_length = REPLY_FRAME_SIZE - sizeof(int);
+    for (int i = 0; i < READ_BATCH; i++) {
+        char* frame = reply_stream + i * REPLY_FRAME_SIZE;
+        memcpy(frame, &frame_length, sizeof(int));
+        write_frame(frame + sizeof(int), MSG_PUNTI_PAROLA, "10", 2);
+    }
+    if (pipe(reply_pipe) == -1) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+    frame_reader_init(&pipe_reader, reply_pipe[0]);
+
+    for (int i = 0; i < 2; i++) {
+        TextBuffer text = { screen_frames[i], RENDER_FRAME_SIZE, 0 };
+        format_title(&text, "PAROLIERE CLIENT");
+        format_matrix(&text, matrix);
+        text_append(&text, BOLD BLUE "Time left: %d" RESET "\n", 42 - i);
+        text_append(&text, BOLD GREEN "Score: 17" RESET "\n");
+        format_title(&text, "Type 'fine' to exit");
+        text_append(&text, YELLOW "\nPAROLIERE CLIENT >> " RESET);
+        screen_frame_lengths[i] = text.length;
+    }
+    screen_init(&screen);
+    screen_diff(&screen, screen_frames[1], screen_frame_lengths[1], true, render_output, sizeof(render_output));
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    parse_bench_options(argc, argv, &options);
+
+    redirect_stdout();
+    srand(BENCH_SEED);
+    prepare_inputs();
+
+    int result = run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]), &options, report);
+
+    fclose(report);
+    return result;
+}
@@ -10,9 +10,10 @@
 #include <time.h>
 
 #include <macros.h>
+#include "client.h"
 
 #define DEFAULT_DURATION 180
 
-void handle_args(int argc, char *argv[], char **serverName, int *serverPort);
+void handle_args(int argc, char *argv[], char **serverName, int *serverPort, ClientOptions *options);
 
 #endif
\ No newline at end of file
@@ -15,16 +15,22 @@
 
 #include "macros.h"
 #include "matrix_handler.h"
+#include "protocol.h"
+#include "frame_reader.h"
+#include "renderer.h"
+#include "rtt.h"
 
-#define MSG_OK 'K'
-#define MSG_ERR 'E'
-#define MSG_REGISTRA_UTENTE 'R'
-#define MSG_MATRICE 'M'
-#define MSG_TEMPO_PARTITA 'T'
-#define MSG_TEMPO_ATTESA 'A'
-#define MSG_PAROLA 'W'
-#define MSG_PUNTI_FINALI 'F'
-#define MSG_PUNTI_PAROLA 'P'
+#define MAX_LEADERBOARD_LENGTH 256
+#define MAX_TERMINAL_MESSAGE_LENGTH 1024
+#define MAX_SCOREBOARD_LINES 10
+
+#define DEFAULT_INFLIGHT 8
+
+// Command line options after the server name and port
+typedef struct {
+    const char* script;  // Commands to run headless, "-" for stdin, NULL for the interactive GUI
+    int inflight;        // Headless requests sent ahead of their replies
+} ClientOptions;
 
 typedef struct {
     // char server_ip[16];
@@ -37,18 +43,21 @@ typedef struct {
     int client_fd;
     int* score;
     char* client_input;
-    char* server_response;
+    FrameReader reader;         // Server frames, read by the messages thread only
     char* terminal_message;
-    int* time_left;
+    char* leaderboard;
+    char* scoreboard;           // Final scoreboard chunks received so far
+    size_t scoreboard_length;
+    size_t scoreboard_capacity;
+    long long time_deadline_ms; // Monotonic time the current phase ends, from the last server time message, 0 before any
+    Renderer* renderer;
+    PendingRing pending;        // Requests sent and waiting for their reply
+    RttStats rtt;               // Round trips of the replies received so far
     pthread_mutex_t thread_mutex;
+    pthread_cond_t time_changed;    // Signaled with time_deadline_ms moved, on the monotonic clock
+    bool countdown_stopping;        // Set under thread_mutex, with time_changed signaled, to end the countdown
 } Thread;
 
-typedef struct {
-    char type;
-    unsigned int size;
-    char* data;
-} Message;
-
-void init_client();
+void init_client(char* server_name, int server_port, const ClientOptions* options);
 
 #endif
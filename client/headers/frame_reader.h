@@ -0,0 +1,33 @@
+#ifndef FRAME_READER_H
+#define FRAME_READER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "protocol.h"
+
+#define FRAME_READER_CHUNK 4096           // Initial buffer size, one read fills as much of it as it can
+#define FRAME_READER_MAX_FRAME (1 << 20)  // Longer length prefixes are treated as a corrupted stream
+
+// Buffered reader of the server frames: [int length][type][int size][data].
+// Frames are handed out as views into the buffer, each valid until the next frame_reader call.
+typedef struct {
+    int fd;
+    char* buffer;      // capacity + 1 bytes, the spare one terminates a payload that ends the buffer
+    size_t capacity;
+    size_t start;      // First byte not handed out yet
+    size_t length;     // Bytes buffered from start
+    char* terminated;  // Byte swapped for the terminator of the last payload handed out, NULL if none
+    char saved;
+} FrameReader;
+
+void frame_reader_init(FrameReader* reader, int fd);
+void frame_reader_destroy(FrameReader* reader);
+// One read from the socket into the free space, read's return value
+ssize_t frame_reader_fill(FrameReader* reader);
+// 1 with a frame in message, 0 when more bytes are needed, -1 for a malformed frame
+int frame_reader_next(FrameReader* reader, Message* message);
+
+#endif
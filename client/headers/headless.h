@@ -0,0 +1,28 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "client.h"
+#include "rtt.h"
+
+#define MAX_SCRIPT_LINE_LENGTH 256
+
+typedef struct {
+    PendingRing pending;      // options->inflight slots
+    RttStats rtt;
+    bool script_done;         // No more requests will be sent
+    long sent;
+    long replies;
+    long errors;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+} PendingQueue;
+
+// Running the script against the connected server, results go to stdout as tab-separated lines
+void run_headless(int client_fd, const ClientOptions* options);
+
+#endif
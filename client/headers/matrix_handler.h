@@ -8,10 +8,15 @@
 #include <ctype.h>
 #include <string.h>
 
+#include "macros.h"
+#include "utils.h"
+
 #define MATRIX_SIZE 4
 #define MATRIX_BYTES (MATRIX_SIZE * MATRIX_SIZE * sizeof(Cell))
+#define MIN_WORD_LENGTH 4 // Shorter words are rejected by the server
 #define MAX_WORD_LENGTH 16
-#define MAX_SERVER_RESPONSE_LENGTH 100
+#define MAX_SERVER_RESPONSE_LENGTH 1024
+#define MATRIX_TEXT_SIZE 2048 // The box-drawn matrix with its escapes, about 1 KB
 
 typedef struct {
     char letter[3];
@@ -19,7 +24,10 @@ typedef struct {
 
 // Function prototypes
 void init_empty_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
+void format_matrix(TextBuffer *text, Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
 void print_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
+bool can_trace_word(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char *word);
+bool is_matrix_empty(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
 // void cleanMatrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSG_OK 'K'
+#define MSG_ERR 'E'
+#define MSG_REGISTRA_UTENTE 'R'
+#define MSG_MATRICE 'M'
+#define MSG_TEMPO_PARTITA 'T'
+#define MSG_TEMPO_ATTESA 'A'
+#define MSG_PAROLA 'W'
+#define MSG_PUNTI_FINALI 'F'
+#define MSG_PUNTI_FINALI_PARZIALI 'f' // A chunk of the final scoreboard, more frames follow
+#define MSG_PUNTI_PAROLA 'P'
+#define MSG_CLASSIFICA 'L' // Live standings: rank,total,username,score,...
+
+typedef struct {
+    char type;
+    unsigned int size;
+    char* data;
+} Message;
+
+// Wire format shared by the interactive client and the load generator
+Message interpret_message(const char* buffer);
+int pack_message(const Message* message, char** buffer);
+
+#endif
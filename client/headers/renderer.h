@@ -0,0 +1,45 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define RENDER_INTERVAL_MS 33       // Updates closer than this are drawn together
+#define RENDER_FRAME_SIZE 8192      // One screen of text with its escapes
+#define RENDER_OUTPUT_SIZE (2 * RENDER_FRAME_SIZE)
+#define RENDER_MAX_LINES 128
+
+// Last screen drawn, the next one only rewrites the lines that differ from it
+typedef struct {
+    char frame[RENDER_FRAME_SIZE];
+    size_t frame_length;
+    bool drawn;                     // false until a full redraw, which is always the first one
+} Screen;
+
+// Draws on its own thread: requests only mark the screen dirty, a frame is composed
+// at most every RENDER_INTERVAL_MS and written with a single write.
+typedef struct {
+    Screen screen;
+    int fd;
+    size_t (*compose)(void *context, char *frame, size_t size); // Returns the frame length
+    void *context;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    bool dirty;
+    bool full_redraw;
+    bool stopping;
+    pthread_t thread;
+    char output[RENDER_OUTPUT_SIZE];
+} Renderer;
+
+void screen_init(Screen *screen);
+size_t screen_diff(Screen *screen, const char *frame, size_t frame_length, bool full_redraw, char *output, size_t output_size);
+
+Renderer* renderer_start(int fd, size_t (*compose)(void *context, char *frame, size_t size), void *context);
+void renderer_request(Renderer *renderer);
+void renderer_invalidate(Renderer *renderer);
+void renderer_stop(Renderer *renderer);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "macros.h"
+#include "utils.h"
+
+#define RTT_SUB_BUCKETS 16      // Per power of two, every bucket is at most 1/16 wide, like the server's histograms
+#define RTT_SUB_BUCKET_BITS 4
+#define RTT_BUCKETS ((64 - RTT_SUB_BUCKET_BITS + 1) * RTT_SUB_BUCKETS)
+#define RTT_COMMANDS 3          // registra_utente, matrice, p
+#define RTT_INTERACTIVE_PENDING 64
+
+// A request sent and not fully answered yet. Replies come back in request order,
+// so the oldest pending request owns every frame that isn't a push.
+typedef struct {
+    long sequence;       // Line number of the command in a headless script, 0 otherwise
+    char type;
+    bool got_body;       // matrice: the matrix or its error arrived, the time left ends the reply. registra_utente: the matrix arrived
+    bool got_time;       // registra_utente: the time left arrived, only the K or the error can follow
+    long long sent_ns;
+} PendingRequest;
+
+typedef struct {
+    PendingRequest* requests;
+    int capacity;
+    int head;
+    int size;
+} PendingRing;
+
+// Log-linear round-trip times in microseconds, from the request's write to the last frame of its reply
+typedef struct {
+    long buckets[RTT_BUCKETS];
+    long count;
+    long errors;
+    long long sum_us;
+    long long max_us;
+} RttHistogram;
+
+typedef struct {
+    RttHistogram commands[RTT_COMMANDS];
+} RttStats;
+
+const char* rtt_request_name(char type);
+
+void pending_ring_init(PendingRing* ring, int capacity);
+void pending_ring_destroy(PendingRing* ring);
+bool pending_ring_push(PendingRing* ring, long sequence, char type, long long sent_ns);
+PendingRequest* rtt_match_frame(PendingRing* ring, RttStats* stats, char frame_type, long long now_ns, bool* terminal);
+
+long long rtt_quantile(const RttHistogram* histogram, double quantile);
+void rtt_format(const RttStats* stats, TextBuffer* text);
+
+#endif
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <unistd.h> // For _exit
 
 #define BOLD "\033[1m"
@@ -27,8 +28,20 @@
 #define YELLOW "\033[33m"
 
 
+// Text built in a fixed buffer, appends past its size are truncated
+typedef struct {
+    char *data;
+    size_t size;
+    size_t length;
+} TextBuffer;
+
 void trim_newline(char *str);
+long long monotonic_ms();
+long long monotonic_ns();
+void sleep_ms(long long duration_ms);
 void handle_error(Error err);
-void print_title();
+void text_append(TextBuffer *text, const char *format, ...);
+void format_title(TextBuffer *text, const char *title);
+void print_title(char *title);
 
 #endif
\ No newline at end of file
@@ -44,8 +44,35 @@ void check_args(int argc, char **server_name, int *server_port) {
     handle_error(err_port);
 }
 
-void handle_args(int argc, char *argv[], char **server_name, int *server_port) {
+void handle_args(int argc, char *argv[], char **server_name, int *server_port, ClientOptions *options) {
+    if (argc < 3) {
+        handle_error(WRONG_PARAMS_ERROR);
+    }
     *server_name = argv[1];
     *server_port = atoi(argv[2]);
     check_args(argc, server_name, server_port);
+
+    options->script = NULL;
+    options->inflight = DEFAULT_INFLIGHT;
+
+    static struct option long_opts[] = {
+        {"script",   required_argument, NULL, 's'},
+        {"inflight", required_argument, NULL, 'i'},
+        {0, 0, 0, 0}
+    };
+
+    // Options come after the server name and port
+    optind = 3;
+    int option;
+    while ((option = getopt_long(argc, argv, "s:i:", long_opts, NULL)) != -1) {
+        switch (option) {
+            case 's': options->script = optarg; break;
+            case 'i': options->inflight = atoi(optarg); break;
+            default: handle_error(WRONG_PARAMS_ERROR);
+        }
+    }
+
+    if (options->inflight <= 0) {
+        handle_error(NEGATIVE_PARAM_ERROR);
+    }
 }
\ No newline at end of file
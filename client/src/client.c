@@ -2,6 +2,7 @@
 #include "macros.h"
 #include "utils.h"
 #include "matrix_handler.h"
+#include "headless.h"
 
 #define MAX_CONF_LINE_LENGTH 64
 
@@ -30,149 +31,213 @@ Error load_config(const char *filename, Config *config) {
     return SUCCESS;
 }
 
-// Function to interpret a message from the server.
-static Message interpret_message(const char* buffer) {
-    Message message = {0};
-    message.type = buffer[0];
-    memcpy(&message.size, buffer + sizeof(char), sizeof(int));
-    message.data = malloc(message.size + 1);
-    if (!message.data) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+// Function to append a chunk of the final scoreboard, chunks are joined with a comma.
+static void append_scoreboard_chunk(Thread* thread, const char* chunk, unsigned int chunk_size) {
+    size_t needed = thread->scoreboard_length + chunk_size + 2;
+    if (needed > thread->scoreboard_capacity) {
+        size_t new_capacity = thread->scoreboard_capacity ? thread->scoreboard_capacity : MAX_SERVER_RESPONSE_LENGTH;
+        while (new_capacity < needed) new_capacity *= 2;
+        char* new_scoreboard = realloc(thread->scoreboard, new_capacity);
+        if (!new_scoreboard) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        thread->scoreboard = new_scoreboard;
+        thread->scoreboard_capacity = new_capacity;
     }
-    memcpy(message.data, buffer + sizeof(char) + sizeof(int), message.size);
-    message.data[message.size] = '\0';
-    return message;
-}
 
-// Resetting player's score, protected by a mutex.
-void reset_player_score(Thread* thread) {
-    pthread_mutex_lock(&thread->thread_mutex);
-    *thread->score = 0;
-    pthread_mutex_unlock(&thread->thread_mutex);
+    if (thread->scoreboard_length > 0 && chunk_size > 0) {
+        thread->scoreboard[thread->scoreboard_length++] = ',';
+    }
+    memcpy(thread->scoreboard + thread->scoreboard_length, chunk, chunk_size);
+    thread->scoreboard_length += chunk_size;
+    thread->scoreboard[thread->scoreboard_length] = '\0';
 }
 
-// Function to serialize a message for sending to the server.
-static int pack_message(const Message* message, char** buffer) {
-    int message_size = sizeof(char) + sizeof(int) + message->size;
-    *buffer = malloc(message_size);
-    if (!*buffer) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+// Function to interpret and store the scoreboard, only the first lines are shown.
+static void interpret_and_store_scoreboard(char* terminal_message, char* scoreboard) {
+    int length = snprintf(terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "FINAL SCOREBOARD\n");
+    char* saveptr;
+    char* token;
+    int position = 1;
+
+    // Parsing the message data.
+    token = strtok_r(scoreboard, ",", &saveptr);
+
+    while (token != NULL) {
+        char* player_username = token;
+        token = strtok_r(NULL, ",", &saveptr);
+        if (token == NULL) break;
+
+        if (position <= MAX_SCOREBOARD_LINES) {
+            length += snprintf(terminal_message + length, MAX_TERMINAL_MESSAGE_LENGTH - length,
+                               position == 1 ? YELLOW "%d° %s - %d\n" RESET : BLUE "%d° %s - %d\n" RESET,
+                               position, player_username, atoi(token));
+        }
+        position++;
+
+        token = strtok_r(NULL, ",", &saveptr);
+    }
+
+    if (position - 1 > MAX_SCOREBOARD_LINES) {
+        snprintf(terminal_message + length, MAX_TERMINAL_MESSAGE_LENGTH - length,
+                 "... and %d more players\n", position - 1 - MAX_SCOREBOARD_LINES);
     }
-    
-    (*buffer)[0] = message->type;
-    memcpy(*buffer + sizeof(char), &(message->size), sizeof(int));
-    memcpy(*buffer + sizeof(char) + sizeof(int), message->data, message->size);
-    return message_size;
 }
 
-// Function to interpret and store the scoreboard.
-static void interpret_and_store_scoreboard(char* terminal_message, const char* message_data) {
+// Function to interpret the live standings: own rank, number of players and the top players.
+static void interpret_and_store_leaderboard(char* leaderboard, const char* message_data) {
     char* rest = strdup(message_data);
     if (!rest) {
         fprintf(stderr, "Memory allocation failed\n");
         exit(EXIT_FAILURE);
     }
 
-    strcpy(terminal_message, "FINAL SCOREBOARD\n");
-    char* token;
-    int position = 1;
+    char* rank = strtok(rest, ",");
+    char* total = strtok(NULL, ",");
+    if (rank == NULL || total == NULL) {
+        free(rest);
+        return;
+    }
 
-    // Parsing the message data.
-    token = strtok(rest, ",");
+    int length = snprintf(leaderboard, MAX_LEADERBOARD_LENGTH, "Rank %s/%s |", rank, total);
+    int position = 1;
+    char* token;
 
-    while (token != NULL) {
+    while ((token = strtok(NULL, ",")) != NULL && length < MAX_LEADERBOARD_LENGTH) {
         char* player_username = token;
         token = strtok(NULL, ",");
         if (token == NULL) break;
 
-        int score = atoi(token);
-
-        char player_score[64];
-        snprintf(player_score, sizeof(player_score), 
-                 position == 1 ? YELLOW "%d° %s - %d\n" RESET : BLUE "%d° %s - %d\n" RESET, 
-                 position, player_username, score);
-        strcat(terminal_message, player_score);
+        length += snprintf(leaderboard + length, MAX_LEADERBOARD_LENGTH - length, " %d. %s %d", position, player_username, atoi(token));
         position++;
-
-        token = strtok(NULL, ",");
     }
-    
+
     free(rest);
 }
 
 // Function to handle a received message and update the client's state accordingly.
-static void handle_received_message(Message* message, Thread* thread) {
+static void handle_received_message(Message* message, Thread* thread, long long received_ns) {
     pthread_mutex_lock(&thread->thread_mutex);
+    // Frames ending a reply time the round trip of the request they answer.
+    bool terminal;
+    rtt_match_frame(&thread->pending, &thread->rtt, message->type, received_ns, &terminal);
+
     switch (message->type) {
         case MSG_MATRICE:
+            if (message->size > MATRIX_BYTES) break; // A matrix frame can't be larger, the payload is left alone
             memcpy(thread->matrix, message->data, message->size);
             thread->terminal_message[0] = '\0';
             break;
         case MSG_PUNTI_PAROLA:
             *thread->score += atoi(message->data);
             if (atoi(message->data) > 0) {
-                sprintf(thread->terminal_message, GREEN "Nice! +%d" RESET, atoi(message->data));
+                snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, GREEN "Nice! +%d" RESET, atoi(message->data));
             } else if (atoi(message->data) == 0) {
-                strcpy(thread->terminal_message, GREEN "Already guessed! +0" RESET);
+                snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", GREEN "Already guessed! +0" RESET);
             } else {
-                strcpy(thread->terminal_message, RED "Invalid word" RESET);
+                snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", RED "Invalid word" RESET);
             }
             break;
         case MSG_TEMPO_PARTITA:
-            *thread->time_left = atoi(message->data);
+            thread->time_deadline_ms = monotonic_ms() + atoi(message->data) * 1000LL;
+            pthread_cond_signal(&thread->time_changed);
             break;
         case MSG_TEMPO_ATTESA:
-            *thread->time_left = atoi(message->data);
-            strcpy(thread->terminal_message, "Waiting for match to start");
+            thread->time_deadline_ms = monotonic_ms() + atoi(message->data) * 1000LL;
+            pthread_cond_signal(&thread->time_changed);
+            snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", "Waiting for match to start");
             init_empty_matrix(thread->matrix);
+            thread->leaderboard[0] = '\0';
+            break;
+        case MSG_CLASSIFICA:
+            interpret_and_store_leaderboard(thread->leaderboard, message->data);
+            break;
+        case MSG_PUNTI_FINALI_PARZIALI:
+            append_scoreboard_chunk(thread, message->data, message->size);
             break;
         case MSG_PUNTI_FINALI:
             init_empty_matrix(thread->matrix);
-            interpret_and_store_scoreboard(thread->terminal_message, message->data);
-            reset_player_score(thread);
+            thread->leaderboard[0] = '\0';
+            append_scoreboard_chunk(thread, message->data, message->size);
+            interpret_and_store_scoreboard(thread->terminal_message, thread->scoreboard);
+            thread->scoreboard_length = 0;
+            *thread->score = 0; // The thread mutex is already held here.
             break;
         default:
-            strcpy(thread->terminal_message, message->data);
+            snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%.*s", (int)message->size, message->data);
             break;
     }
 
     pthread_mutex_unlock(&thread->thread_mutex);
 }
 
-// Function to display the game GUI, showing the current game state.
-static void show_game_GUI(const Thread* messages_thread) {
-    if (!messages_thread) {
-        fprintf(stderr, "Thread data is not available\n");
-        return;
+// Appending a multi-line text, each line carrying its own color so it can be redrawn alone.
+static void append_colored_lines(TextBuffer* text, const char* color, const char* lines) {
+    while (*lines) {
+        const char* newline = strchr(lines, '\n');
+        int length = newline ? newline - lines : (int)strlen(lines);
+        text_append(text, "%s%.*s" RESET "\n", color, length, lines);
+        lines += newline ? length + 1 : length;
     }
+}
 
-    printf(CLEAR);
-    print_title("PAROLIERE CLIENT");
+// Composing the game screen from the current state, the renderer draws what changed since the last one.
+static size_t compose_game_screen(void* context, char* frame, size_t size) {
+    Thread* thread = (Thread*)context;
+    TextBuffer text = { frame, size, 0 };
+    frame[0] = '\0';
 
-    if (messages_thread->matrix) {
-        print_matrix(messages_thread->matrix);
-    }
+    pthread_mutex_lock(&thread->thread_mutex);
+    format_title(&text, "PAROLIERE CLIENT");
+    format_matrix(&text, thread->matrix);
 
-    if (*messages_thread->time_left != 0) {
-        printf(BOLD BLUE"Time left: %d"RESET, *messages_thread->time_left);
+    if (thread->time_deadline_ms != 0) {
+        // Rounded up like the server does, the countdown shows 0 only once the phase is over.
+        long long remaining_ms = thread->time_deadline_ms - monotonic_ms();
+        text_append(&text, BOLD BLUE "Time left: %lld" RESET "\n", remaining_ms > 0 ? (remaining_ms + 999) / 1000 : 0);
     } else {
-        printf(BOLD BLUE"Check the time using the command 'matrice'"RESET);
+        text_append(&text, BOLD BLUE "The time left shows up once you're registered" RESET "\n");
     }
+    text_append(&text, BOLD GREEN "Score: %d" RESET "\n", *thread->score);
+    // Kept as a line even when empty, so the rows below don't move when the standings come and go.
+    text_append(&text, YELLOW "%s" RESET "\n", thread->leaderboard);
+
+    format_title(&text, "Type 'fine' to exit");
 
-    if (messages_thread->score) {
-        printf(BOLD GREEN"\nScore: %d\n"RESET, *messages_thread->score);
+    if (thread->terminal_message[0]) {
+        text_append(&text, "\n");
+        append_colored_lines(&text, BLUE, thread->terminal_message);
     }
+    pthread_mutex_unlock(&thread->thread_mutex);
+
+    text_append(&text, YELLOW "\nPAROLIERE CLIENT >> " RESET);
+    return text.length;
+}
 
-    print_title("Type 'fine' to exit");
+// Thread function counting down locally, the screen is redrawn whenever the second shown changes.
+// The deadline is moved by every server time message, so the server is never polled for the time.
+static void* countdown_thread(void* arg) {
+    Thread* thread = (Thread*)arg;
+
+    pthread_mutex_lock(&thread->thread_mutex);
+    while (!thread->countdown_stopping) {
+        long long remaining_ms = thread->time_deadline_ms - monotonic_ms();
+        if (thread->time_deadline_ms == 0 || remaining_ms <= 0) {
+            pthread_cond_wait(&thread->time_changed, &thread->thread_mutex);
+            continue;
+        }
 
-    if (messages_thread->terminal_message && messages_thread->terminal_message[0]) {
-       printf(BLUE"\n%s\n"RESET, messages_thread->terminal_message);
+        // Waking up right when the rounded up seconds go down by one, or earlier for a new deadline.
+        long long wake_ms = monotonic_ms() + (remaining_ms - 1) % 1000 + 1;
+        struct timespec wake = { wake_ms / 1000, (wake_ms % 1000) * 1000000L };
+        if (pthread_cond_timedwait(&thread->time_changed, &thread->thread_mutex, &wake) == ETIMEDOUT) {
+            renderer_request(thread->renderer);
+        }
     }
+    pthread_mutex_unlock(&thread->thread_mutex);
 
-    printf(YELLOW "\nPAROLIERE CLIENT >> " RESET);
-    fflush(stdout);
+    return NULL;
 }
 
 // Thread function to handle incoming messages from the server.
@@ -183,34 +248,33 @@ void* handle_messages_thread(void* arg) {
         return NULL;
     }
 
+    FrameReader* reader = &messages_thread->reader;
+    // Frames are timed when the read bringing them returns, before they wait for the lock or the screen.
+    long long received_ns = 0;
     while (1) {
-        // Read the message length first.
-        int message_length;
-        ssize_t bytes_read = read(messages_thread->client_fd, &message_length, sizeof(int));
-        if (bytes_read <= 0) {
-            fprintf(stderr, "Error reading message length from server or connection closed\n");
+        // Handling every complete frame already buffered, they point into the reader's buffer.
+        Message message;
+        int result;
+        while ((result = frame_reader_next(reader, &message)) == 1) {
+            handle_received_message(&message, messages_thread, received_ns);
+            renderer_request(messages_thread->renderer);
+        }
+
+        if (result < 0) {
+            fprintf(stderr, "Invalid message from server\n");
             handle_error(SERVER_CLOSED_ERROR);
             break;
         }
 
-        // Reading the actual message based on the length.
-        bytes_read = read(messages_thread->client_fd, messages_thread->server_response, message_length);
+        // Reading as much as the socket has, the reader grows for frames longer than its buffer.
+        ssize_t bytes_read = frame_reader_fill(reader);
+        if (bytes_read == -1 && errno == EINTR) continue;
         if (bytes_read <= 0) {
             fprintf(stderr, "Error reading message from server or connection closed\n");
             handle_error(SERVER_CLOSED_ERROR);
             break;
         }
-
-        // Ensuring null-termination if necessary.
-        if (bytes_read < MAX_SERVER_RESPONSE_LENGTH) {
-            messages_thread->server_response[bytes_read] = '\0';
-        }
-
-        // Interpret and handle the message.
-        Message message = interpret_message(messages_thread->server_response);
-        handle_received_message(&message, messages_thread);
-        free(message.data);
-        show_game_GUI(messages_thread);
+        received_ns = monotonic_ns();
     }
 
     return NULL;
@@ -222,8 +286,15 @@ static void execute_command(const char* command, const char* content, Thread* th
     char* buffer = NULL;
 
     if (strcmp(command, "aiuto") == 0) {
-        strcpy(thread->terminal_message, "Comandi disponibili:\naiuto\nregistra_utente <username>\nmatrice\np <parola>\nfine\n");
-        show_game_GUI(thread);
+        snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", "Comandi disponibili:\naiuto\nregistra_utente <username>\nmatrice\np <parola>\nstats\nfine\n");
+        renderer_request(thread->renderer);
+        return;
+    }
+
+    if (strcmp(command, "stats") == 0) {
+        TextBuffer text = { thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, 0 };
+        rtt_format(&thread->rtt, &text);
+        renderer_request(thread->renderer);
         return;
     }
 
@@ -239,8 +310,8 @@ static void execute_command(const char* command, const char* content, Thread* th
     } else if (strcmp(command, "p") == 0) {
         message.type = MSG_PAROLA;
     } else {
-        strcpy(thread->terminal_message, "Comando non riconosciuto. Digita 'aiuto' per vedere i comandi disponibili.\n");
-        show_game_GUI(thread);
+        snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", "Comando non riconosciuto. Digita 'aiuto' per vedere i comandi disponibili.\n");
+        renderer_request(thread->renderer);
         return;
     }
 
@@ -249,8 +320,22 @@ static void execute_command(const char* command, const char* content, Thread* th
     for (int i = 0; message.data[i]; i++) {
         message.data[i] = tolower(message.data[i]);
     }
-    int message_size = pack_message(&message, &buffer);
 
+    // Words that can't be traced on the board we have don't reach the server, which still checks every word it gets.
+    if (message.type == MSG_PAROLA && !is_matrix_empty(thread->matrix) && !can_trace_word(thread->matrix, message.data)) {
+        snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", "Invalid word");
+        renderer_request(thread->renderer);
+        return;
+    }
+
+    // The reply can't be matched before this returns, the messages thread needs the lock held here.
+    if (!pending_ring_push(&thread->pending, 0, message.type, monotonic_ns())) {
+        snprintf(thread->terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "%s", "Too many requests waiting for a reply, try again");
+        renderer_request(thread->renderer);
+        return;
+    }
+
+    int message_size = pack_message(&message, &buffer);
     if (write(thread->client_fd, buffer, message_size) != message_size) {
         fprintf(stderr, "Failed to send message to server\n");
     }
@@ -274,7 +359,7 @@ void send_message(void* arg) {
 }
 
 // Function to initialize the client and start the connection.
-void init_client(char* server_name, int server_port) {
+void init_client(char* server_name, int server_port, const ClientOptions* options) {
     // Load configuration file.
     Config config;
     Error err = load_config("config.txt", &config);
@@ -284,7 +369,7 @@ void init_client(char* server_name, int server_port) {
     Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
 
     // Socket file descriptor and last return value (will be used in system calls).
-    int client_socket_fd, last_ret_value, client_score = 0, time_left = 0;
+    int client_socket_fd, last_ret_value, client_score = 0;
     // Structs for server and client addresses.
     struct sockaddr_in server_addr;
 
@@ -293,15 +378,15 @@ void init_client(char* server_name, int server_port) {
     NEW_MEMORY_ALLOCATION(client_input, 64, "Failed to allocate memory for client input message");
     memset(client_input, 0, 64);
 
-    // This will be used to store the server response.
-    char* server_response;
-    NEW_MEMORY_ALLOCATION(server_response, 64, "Failed to allocate memory for server response");
-    memset(server_response, 0, 64);
-
     // This will be used to show the server response.
     char* terminal_message;
-    NEW_MEMORY_ALLOCATION(terminal_message, 64, "Failed to allocate memory for terminal message");
-    memset(terminal_message, 0, 64);
+    NEW_MEMORY_ALLOCATION(terminal_message, MAX_TERMINAL_MESSAGE_LENGTH, "Failed to allocate memory for terminal message");
+    memset(terminal_message, 0, MAX_TERMINAL_MESSAGE_LENGTH);
+
+    // This will be used to show the live standings during the game.
+    char* leaderboard;
+    NEW_MEMORY_ALLOCATION(leaderboard, MAX_LEADERBOARD_LENGTH, "Failed to allocate memory for leaderboard");
+    memset(leaderboard, 0, MAX_LEADERBOARD_LENGTH);
 
     // For reference on sockets: https://beej.us/guide/bgnet/html//index.html#slightly-advanced-techniques.
     // Socket Creation.
@@ -315,11 +400,23 @@ void init_client(char* server_name, int server_port) {
         server_name = "127.0.0.1";
     }
     SYSC(last_ret_value, inet_pton(AF_INET, server_name, &server_addr.sin_addr), "Invalid address");
-    printf("Waiting for connection... on %s:%d\n", server_name, server_port);
+    // In headless mode stdout only carries the results.
+    FILE* status_output = options->script ? stderr : stdout;
+    fprintf(status_output, "Waiting for connection... on %s:%d\n", server_name, server_port);
 
     // Connecting to the server.
     SYSC(last_ret_value, connect(client_socket_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)), "connect to server failed");
 
+    if (options->script) {
+        fprintf(status_output, "Connected to the server\n");
+        free(client_input);
+        free(terminal_message);
+        free(leaderboard);
+        run_headless(client_socket_fd, options);
+        close(client_socket_fd);
+        return;
+    }
+
     printf(GREEN "Connected to the server\n" RESET);
 
     // Setting up the thread.
@@ -330,24 +427,44 @@ void init_client(char* server_name, int server_port) {
         .client_fd = client_socket_fd,
         .score = &client_score,
         .client_input = client_input,
-        .server_response = server_response,
         .terminal_message = terminal_message,
-        .time_left = &time_left
+        .leaderboard = leaderboard,
+        .time_deadline_ms = 0
     };
+    // The matrix starts empty, it will be filled by the server later on.
+    init_empty_matrix(matrix);
+
+    // The countdown waits on the monotonic clock, like the deadline it counts to.
+    pthread_condattr_t time_changed_attributes;
+    pthread_condattr_init(&time_changed_attributes);
+    pthread_condattr_setclock(&time_changed_attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&messages_thread.time_changed, &time_changed_attributes);
+    pthread_condattr_destroy(&time_changed_attributes);
+
+    // The server responses are read into this buffer.
+    frame_reader_init(&messages_thread.reader, client_socket_fd);
+    // Requests are timed until their reply, an interactive session rarely has more than one waiting.
+    pending_ring_init(&messages_thread.pending, RTT_INTERACTIVE_PENDING);
+    // Drawing the screen on its own thread, bursts of updates become one frame.
+    messages_thread.renderer = renderer_start(STDOUT_FILENO, compose_game_screen, &messages_thread);
 
     if (pthread_create(&message_thread_id, NULL, handle_messages_thread, (void *)&messages_thread) != 0) {
         free(client_input);
-        free(server_response);
+        frame_reader_destroy(&messages_thread.reader);
         free(terminal_message);
+        free(leaderboard);
         close(client_socket_fd);
         handle_error(THREAD_CREATION_ERROR);
     }
 
-    // The matrix starts empty, it will be filled by the server later on.
-    init_empty_matrix(matrix);
+    // Counting the time left down between the server's time messages.
+    pthread_t countdown_thread_id;
+    if (pthread_create(&countdown_thread_id, NULL, countdown_thread, (void *)&messages_thread) != 0) {
+        handle_error(THREAD_CREATION_ERROR);
+    }
 
     // Displaying the shell GUI for the game. It will be updated by the thread making it look like a real-time game.
-    show_game_GUI(&messages_thread);
+    renderer_request(messages_thread.renderer);
 
     // Main loop.
     while (1) {
@@ -357,18 +474,40 @@ void init_client(char* server_name, int server_port) {
         // User Exit.
         if (strcmp(client_input, "fine") == 0) break;
 
+        // The input moved the cursor off the prompt, the next frame is drawn from scratch.
+        renderer_invalidate(messages_thread.renderer);
+
         send_message((void *)&messages_thread);
     }
 
+    // Stopping the countdown first, it still asks the renderer for frames.
+    pthread_mutex_lock(&messages_thread.thread_mutex);
+    messages_thread.countdown_stopping = true;
+    pthread_cond_signal(&messages_thread.time_changed);
+    pthread_mutex_unlock(&messages_thread.thread_mutex);
+    pthread_join(countdown_thread_id, NULL);
+
     // Stopping and removing thread.
     pthread_cancel(message_thread_id);
     pthread_join(message_thread_id, NULL);
     pthread_mutex_destroy(&thread_mutex);
+    // No frame is drawn from here on, the state below can be freed.
+    renderer_stop(messages_thread.renderer);
+    pthread_cond_destroy(&messages_thread.time_changed);
+
+    // Printing the round trips of the session, the messages thread is gone so they don't change anymore.
+    char rtt_table[1024];
+    TextBuffer rtt_text = { rtt_table, sizeof(rtt_table), 0 };
+    rtt_format(&messages_thread.rtt, &rtt_text);
+    printf("\nRound trip times\n%s", rtt_table);
 
     // Freeing memory.
     free(client_input);
-    free(server_response);
+    frame_reader_destroy(&messages_thread.reader);
+    pending_ring_destroy(&messages_thread.pending);
     free(terminal_message);
+    free(leaderboard);
+    free(messages_thread.scoreboard);
 
     // Closing the server socket.
     SYSC(last_ret_value, close(client_socket_fd), "Failed closing the socket");
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "frame_reader.h"
+
+#define FRAME_LENGTH_SIZE sizeof(int)
+#define FRAME_HEADER_SIZE (sizeof(char) + sizeof(int)) // Type and payload size, after the length
+
+void frame_reader_init(FrameReader* reader, int fd) {
+    reader->fd = fd;
+    reader->capacity = FRAME_READER_CHUNK;
+    reader->buffer = malloc(reader->capacity + 1);
+    if (!reader->buffer) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    reader->start = 0;
+    reader->length = 0;
+    reader->terminated = NULL;
+}
+
+void frame_reader_destroy(FrameReader* reader) {
+    free(reader->buffer);
+    reader->buffer = NULL;
+}
+
+// Giving back the byte the last payload's terminator replaced, it belongs to the next frame
+static void restore_terminated(FrameReader* reader) {
+    if (reader->terminated) {
+        *reader->terminated = reader->saved;
+        reader->terminated = NULL;
+    }
+}
+
+// Length of the frame at the front, -1 if it can't be one
+static long pending_frame_length(const FrameReader* reader) {
+    int frame_length;
+    memcpy(&frame_length, reader->buffer + reader->start, FRAME_LENGTH_SIZE);
+    if (frame_length < (int)FRAME_HEADER_SIZE || frame_length > FRAME_READER_MAX_FRAME) {
+        return -1;
+    }
+    return frame_length;
+}
+
+// Moving the partial frame to the front and growing the buffer when the frame wouldn't fit
+ssize_t frame_reader_fill(FrameReader* reader) {
+    restore_terminated(reader);
+
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->length);
+        reader->start = 0;
+    }
+
+    size_t needed = reader->length + 1;
+    if (reader->length >= FRAME_LENGTH_SIZE) {
+        long frame_length = pending_frame_length(reader);
+        if (frame_length > 0 && FRAME_LENGTH_SIZE + frame_length > needed) {
+            needed = FRAME_LENGTH_SIZE + frame_length;
+        }
+    }
+    if (needed > reader->capacity) {
+        size_t new_capacity = reader->capacity * 2;
+        while (new_capacity < needed) new_capacity *= 2;
+        char* new_buffer = realloc(reader->buffer, new_capacity + 1);
+        if (!new_buffer) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        reader->buffer = new_buffer;
+        reader->capacity = new_capacity;
+    }
+
+    ssize_t bytes_read = read(reader->fd, reader->buffer + reader->length, reader->capacity - reader->length);
+    if (bytes_read > 0) {
+        reader->length += bytes_read;
+    }
+    return bytes_read;
+}
+
+// Extracting the next complete frame without copying it, its payload is terminated in place
+int frame_reader_next(FrameReader* reader, Message* message) {
+    restore_terminated(reader);
+
+    if (reader->length < FRAME_LENGTH_SIZE) {
+        return 0;
+    }
+    long frame_length = pending_frame_length(reader);
+    if (frame_length < 0) {
+        return -1;
+    }
+    if (reader->length < FRAME_LENGTH_SIZE + frame_length) {
+        return 0;
+    }
+
+    char* frame = reader->buffer + reader->start + FRAME_LENGTH_SIZE;
+    int size;
+    memcpy(&size, frame + sizeof(char), sizeof(int));
+    if (size < 0 || size > frame_length - (long)FRAME_HEADER_SIZE) {
+        return -1;
+    }
+
+    message->type = frame[0];
+    message->size = size;
+    message->data = frame + FRAME_HEADER_SIZE;
+    reader->terminated = message->data + size;
+    reader->saved = *reader->terminated;
+    *reader->terminated = '\0';
+
+    reader->start += FRAME_LENGTH_SIZE + frame_length;
+    reader->length -= FRAME_LENGTH_SIZE + frame_length;
+    return 1;
+}
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "headless.h"
+#include "frame_reader.h"
+#include "matrix_handler.h"
+#include "macros.h"
+#include "utils.h"
+
+// Script commands are the interactive ones (registra_utente <username>, matrice, p <parola>, stats, fine),
+// plus "wait" for every reply so far and "sleep <ms>". "stats" prints the round trips so far as comment lines. Empty lines and lines starting with # are skipped.
+// Each frame received is printed as: sequence, request, reply type, latency in us, data.
+// Pushes have sequence 0 and request "-", frames in the middle of a reply have latency "-".
+
+typedef struct {
+    int fd;
+    FILE* script;
+    PendingQueue* queue;
+} ScriptSender;
+
+static void write_request(int fd, char type, const char* content) {
+    Message message = { .type = type, .size = strlen(content), .data = (char*)content };
+    char* buffer = NULL;
+    int message_size = pack_message(&message, &buffer);
+    if (write(fd, buffer, message_size) != message_size) {
+        fprintf(stderr, "Failed to send message to server\n");
+    }
+    free(buffer);
+}
+
+// Round trips per command, as comment lines
+static void print_rtt(const RttStats* stats) {
+    char table[1024];
+    TextBuffer text = { table, sizeof(table), 0 };
+    rtt_format(stats, &text);
+    for (char* line = strtok(table, "\n"); line; line = strtok(NULL, "\n")) {
+        printf("# %s\n", line);
+    }
+}
+
+// Sending the script's requests as they come, as long as fewer than --inflight are waiting for their reply
+static void* send_script(void* arg) {
+    ScriptSender* sender = (ScriptSender*)arg;
+    PendingQueue* queue = sender->queue;
+    char line[MAX_SCRIPT_LINE_LENGTH];
+    long line_number = 0;
+
+    while (fgets(line, sizeof(line), sender->script)) {
+        line_number++;
+        trim_newline(line);
+        char command[32] = {0};
+        char content[MAX_SCRIPT_LINE_LENGTH] = {0};
+        if (line[0] == '#' || sscanf(line, "%31s%*c%255[^\n]", command, content) < 1) continue;
+
+        if (strcmp(command, "fine") == 0) break;
+
+        if (strcmp(command, "sleep") == 0) {
+            sleep_ms(atoll(content));
+            continue;
+        }
+
+        pthread_mutex_lock(&queue->mutex);
+        if (strcmp(command, "stats") == 0) {
+            print_rtt(&queue->rtt);
+            fflush(stdout);
+            pthread_mutex_unlock(&queue->mutex);
+            continue;
+        }
+
+        if (strcmp(command, "wait") == 0) {
+            while (queue->pending.size > 0) {
+                pthread_cond_wait(&queue->changed, &queue->mutex);
+            }
+            pthread_mutex_unlock(&queue->mutex);
+            continue;
+        }
+
+        char type = 0;
+        if (strcmp(command, "registra_utente") == 0) {
+            type = MSG_REGISTRA_UTENTE;
+        } else if (strcmp(command, "matrice") == 0) {
+            type = MSG_MATRICE;
+        } else if (strcmp(command, "p") == 0) {
+            type = MSG_PAROLA;
+        } else {
+            pthread_mutex_unlock(&queue->mutex);
+            fprintf(stderr, "Script line %ld: unknown command '%s'\n", line_number, command);
+            continue;
+        }
+
+        while (!pending_ring_push(&queue->pending, line_number, type, monotonic_ns())) {
+            pthread_cond_wait(&queue->changed, &queue->mutex);
+        }
+        queue->sent++;
+        pthread_mutex_unlock(&queue->mutex);
+
+        for (int i = 0; content[i]; i++) {
+            content[i] = tolower(content[i]);
+        }
+        write_request(sender->fd, type, content);
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->script_done = true;
+    // Nothing left to wait for: the reader is woken up from its read.
+    if (queue->pending.size == 0) {
+        shutdown(sender->fd, SHUT_RD);
+    }
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->mutex);
+    return NULL;
+}
+
+// Printing the payload on one line: matrices as their cells, text with its control characters escaped
+static void print_data(const Message* message) {
+    if (message->type == MSG_MATRICE && message->size == MATRIX_BYTES) {
+        const Cell* cells = (const Cell*)message->data;
+        for (int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++) {
+            printf(i > 0 ? ",%s" : "%s", cells[i].letter);
+        }
+        return;
+    }
+
+    for (unsigned int i = 0; i < message->size; i++) {
+        unsigned char c = message->data[i];
+        if (c == '\n') fputs("\\n", stdout);
+        else if (c == '\t') fputs("\\t", stdout);
+        else if (c == '\\') fputs("\\\\", stdout);
+        else if (c < 0x20 || c == 0x7f) printf("\\x%02x", c);
+        else putchar(c);
+    }
+}
+
+// Matching and printing one frame, returns true once the script is over and every reply is in
+static bool handle_frame(PendingQueue* queue, const Message* message) {
+    pthread_mutex_lock(&queue->mutex);
+    long long received_ns = monotonic_ns();
+    bool terminal;
+    PendingRequest* request = rtt_match_frame(&queue->pending, &queue->rtt, message->type, received_ns, &terminal);
+
+    if (!request) {
+        printf("0\t-\t%c\t-\t", message->type);
+    } else if (!terminal) {
+        printf("%ld\t%s\t%c\t-\t", request->sequence, rtt_request_name(request->type), message->type);
+    } else {
+        printf("%ld\t%s\t%c\t%lld\t", request->sequence, rtt_request_name(request->type), message->type,
+               (received_ns - request->sent_ns) / 1000);
+    }
+    print_data(message);
+    putchar('\n');
+
+    if (terminal) {
+        queue->replies++;
+        if (message->type == MSG_ERR) queue->errors++;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    bool done = queue->script_done && queue->pending.size == 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return done;
+}
+
+void run_headless(int client_fd, const ClientOptions* options) {
+    FILE* script = stdin;
+    if (strcmp(options->script, "-") != 0) {
+        SYSCN(script, fopen(options->script, "r"), "Failed to open the script");
+    }
+
+    // Requests go out one write each, without waiting for the acks of the ones still in flight.
+    int flag = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    PendingQueue queue = {0};
+    pending_ring_init(&queue.pending, options->inflight);
+    pthread_mutex_init(&queue.mutex, NULL);
+    pthread_cond_init(&queue.changed, NULL);
+
+    printf("# sequence\trequest\treply\tlatency_us\tdata\n");
+    long long start_ns = monotonic_ns();
+
+    ScriptSender sender = { .fd = client_fd, .script = script, .queue = &queue };
+    pthread_t sender_thread;
+    if (pthread_create(&sender_thread, NULL, send_script, &sender) != 0) {
+        handle_error(THREAD_CREATION_ERROR);
+    }
+
+    FrameReader reader;
+    frame_reader_init(&reader, client_fd);
+    bool done = false;
+    while (!done) {
+        Message message;
+        int result;
+        while (!done && (result = frame_reader_next(&reader, &message)) == 1) {
+            done = handle_frame(&queue, &message);
+        }
+        if (done) break;
+        if (result < 0) {
+            fprintf(stderr, "Invalid message from server\n");
+            break;
+        }
+
+        ssize_t bytes_read = frame_reader_fill(&reader);
+        if (bytes_read == -1 && errno == EINTR) continue;
+        if (bytes_read <= 0) {
+            pthread_mutex_lock(&queue.mutex);
+            done = queue.script_done && queue.pending.size == 0; // Woken up by the sender, not closed by the server
+            pthread_mutex_unlock(&queue.mutex);
+            if (!done) {
+                fprintf(stderr, "Error reading message from server or connection closed\n");
+            }
+            break;
+        }
+    }
+
+    double elapsed = (monotonic_ns() - start_ns) / 1e9;
+    pthread_mutex_lock(&queue.mutex);
+    printf("# %ld requests, %ld replies, %ld errors in %.3f s, %.0f requests/s\n",
+           queue.sent, queue.replies, queue.errors, elapsed, elapsed > 0 ? queue.replies / elapsed : 0);
+    bool complete = queue.script_done && queue.pending.size == 0;
+    print_rtt(&queue.rtt);
+    pthread_mutex_unlock(&queue.mutex);
+    fflush(stdout);
+
+    if (!complete) {
+        exit(SERVER_CLOSED_ERROR.code);
+    }
+    pthread_join(sender_thread, NULL);
+    frame_reader_destroy(&reader);
+    pending_ring_destroy(&queue.pending);
+    if (script != stdin) {
+        fclose(script);
+    }
+}
@@ -7,9 +7,10 @@
 int main(int argc, char *argv[]) {
     char* server_name;
     int port;
+    ClientOptions options;
 
-    handle_args(argc, argv, &server_name, &port);
-    init_client(server_name, port);
+    handle_args(argc, argv, &server_name, &port, &options);
+    init_client(server_name, port, &options);
     
     return 0;
 }
\ No newline at end of file
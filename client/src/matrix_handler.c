@@ -3,55 +3,63 @@
 #include "utils.h"
 
 
-void print_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
+void format_matrix(TextBuffer *text, Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
 
     // Top part
-    printf("   " BOX_TOP_LEFT);
+    text_append(text, "   " BOX_TOP_LEFT);
     for (int i = 0; i < MATRIX_SIZE; i++) {
-        printf(BOX_HORIZONTAL BOX_HORIZONTAL BOX_HORIZONTAL); // 3 is optimal number of spaces
-        if (i < MATRIX_SIZE - 1) printf(BOX_T_DOWN); // leaving space for right border 
+        text_append(text, BOX_HORIZONTAL BOX_HORIZONTAL BOX_HORIZONTAL); // 3 is optimal number of spaces
+        if (i < MATRIX_SIZE - 1) text_append(text, BOX_T_DOWN); // leaving space for right border 
     }
-    printf(BOX_TOP_RIGHT "\n");
+    text_append(text, BOX_TOP_RIGHT "\n");
 
     // Middle
     for (int i = 0; i < MATRIX_SIZE; i++) {
-        printf(" %d " BOX_VERTICAL, i + 1); // n of row + initial vertical separator
+        text_append(text, " %d " BOX_VERTICAL, i + 1); // n of row + initial vertical separator
         for (int j = 0; j < MATRIX_SIZE; j++) {
             // Number in cell (takes 1 space in horizontal, we are now in the middle since the top is already taken)
             if (strcmp(matrix[i][j].letter, "Qu") == 0) {
-                printf(BOLD " %s" RESET, matrix[i][j].letter);
+                text_append(text, BOLD " %s" RESET, matrix[i][j].letter);
             } else {
-                printf(BOLD " %s " RESET, matrix[i][j].letter);
+                text_append(text, BOLD " %s " RESET, matrix[i][j].letter);
             }
-            printf(BOX_VERTICAL);
+            text_append(text, BOX_VERTICAL);
         }
-        printf("\n");
+        text_append(text, "\n");
 
         // bottom part of the middle: top part is taken, middle is number, third bottom is the bottom part of the cell
         if (i < MATRIX_SIZE - 1) {
-            printf("   " BOX_T_RIGHT); // unite with top line, then go right
+            text_append(text, "   " BOX_T_RIGHT); // unite with top line, then go right
             for (int j = 0; j < MATRIX_SIZE; j++) {
-                printf(BOX_HORIZONTAL BOX_HORIZONTAL BOX_HORIZONTAL); // usual 3 spaces
-                if (j < MATRIX_SIZE - 1) printf(BOX_CROSS); // close all gaps
+                text_append(text, BOX_HORIZONTAL BOX_HORIZONTAL BOX_HORIZONTAL); // usual 3 spaces
+                if (j < MATRIX_SIZE - 1) text_append(text, BOX_CROSS); // close all gaps
             }
-            printf(BOX_T_LEFT "\n"); // unite with top line and close the gap on the left
+            text_append(text, BOX_T_LEFT "\n"); // unite with top line and close the gap on the left
         }
     }
 
     // Bottom
-    printf("   " BOX_BOTTOM_LEFT);
+    text_append(text, "   " BOX_BOTTOM_LEFT);
     for (int i = 0; i < MATRIX_SIZE; i++) {
-        printf(BOX_HORIZONTAL BOX_HORIZONTAL BOX_HORIZONTAL);
-        if (i < MATRIX_SIZE - 1) printf(BOX_T_UP);
+        text_append(text, BOX_HORIZONTAL BOX_HORIZONTAL BOX_HORIZONTAL);
+        if (i < MATRIX_SIZE - 1) text_append(text, BOX_T_UP);
     }
-    printf(BOX_BOTTOM_RIGHT "\n");
+    text_append(text, BOX_BOTTOM_RIGHT "\n");
 
     // column numbers
-    printf("\n    ");
+    text_append(text, "\n    ");
     for (int i = 0; i < MATRIX_SIZE; i++) {
-        printf(" %d  ", i + 1);
+        text_append(text, " %d  ", i + 1);
     }
-    printf("\n\n");
+    text_append(text, "\n\n");
+}
+
+void print_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
+    char data[MATRIX_TEXT_SIZE];
+    TextBuffer text = { data, sizeof(data), 0 };
+    data[0] = '\0';
+    format_matrix(&text, matrix);
+    fputs(data, stdout);
 }
 
 void init_empty_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
@@ -60,4 +68,64 @@ void init_empty_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
             strcpy(matrix[i][j].letter, " ");  // Set each cell to a single space
         }
     }
-}
\ No newline at end of file
+}
+
+// Italian letters only, as on the server: words with other letters can't be on the board.
+static bool is_board_letter(char letter) {
+    return letter != '\0' && strchr("ABCDEFGHILMNOPQRSTUVZ", toupper(letter)) != NULL;
+}
+
+// Matching the cell against the word at index, "qu" always takes a "Qu" cell. Returns the characters consumed, 0 if none.
+static int match_cell(const Cell *cell, const char *word, int index) {
+    bool qu = tolower(word[index]) == 'q' && tolower(word[index + 1]) == 'u';
+    if (qu) {
+        return strcmp(cell->letter, "Qu") == 0 ? 2 : 0;
+    }
+    return is_board_letter(word[index]) && cell->letter[1] == '\0' && toupper(cell->letter[0]) == toupper(word[index]) ? 1 : 0;
+}
+
+// Depth-first search with the server's form_word rules: horizontal or vertical steps, each cell used once.
+static bool trace_word(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char *word, int index, int row, int col, bool used[MATRIX_SIZE][MATRIX_SIZE]) {
+    if (word[index] == '\0') return true;
+
+    static const int moves[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+    for (int i = 0; i < 4; i++) {
+        int next_row = row + moves[i][0], next_col = col + moves[i][1];
+        if (next_row < 0 || next_row >= MATRIX_SIZE || next_col < 0 || next_col >= MATRIX_SIZE || used[next_row][next_col]) continue;
+        int consumed = match_cell(&matrix[next_row][next_col], word, index);
+        if (consumed == 0) continue;
+
+        used[next_row][next_col] = true;
+        if (trace_word(matrix, word, index + consumed, next_row, next_col, used)) return true;
+        used[next_row][next_col] = false;
+    }
+    return false;
+}
+
+// Checking locally whether the server could accept the word on this board, the dictionary is left to the server.
+bool can_trace_word(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char *word) {
+    int word_len = strlen(word);
+    if (word_len < MIN_WORD_LENGTH || word_len > MAX_WORD_LENGTH) return false;
+
+    for (int i = 0; i < MATRIX_SIZE; i++) {
+        for (int j = 0; j < MATRIX_SIZE; j++) {
+            int consumed = match_cell(&matrix[i][j], word, 0);
+            if (consumed == 0) continue;
+
+            bool used[MATRIX_SIZE][MATRIX_SIZE] = {{false}};
+            used[i][j] = true;
+            if (trace_word(matrix, word, consumed, i, j, used)) return true;
+        }
+    }
+    return false;
+}
+
+// True until a round's matrix is received: the board is all blank cells.
+bool is_matrix_empty(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
+    for (int i = 0; i < MATRIX_SIZE; i++) {
+        for (int j = 0; j < MATRIX_SIZE; j++) {
+            if (strcmp(matrix[i][j].letter, " ") != 0) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+
+// Function to interpret a message from the server.
+Message interpret_message(const char* buffer) {
+    Message message = {0};
+    message.type = buffer[0];
+    memcpy(&message.size, buffer + sizeof(char), sizeof(int));
+    message.data = malloc(message.size + 1);
+    if (!message.data) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(message.data, buffer + sizeof(char) + sizeof(int), message.size);
+    message.data[message.size] = '\0';
+    return message;
+}
+
+// Function to serialize a message for sending to the server.
+int pack_message(const Message* message, char** buffer) {
+    int message_size = sizeof(char) + sizeof(int) + message->size;
+    *buffer = malloc(message_size);
+    if (!*buffer) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    (*buffer)[0] = message->type;
+    memcpy(*buffer + sizeof(char), &(message->size), sizeof(int));
+    memcpy(*buffer + sizeof(char) + sizeof(int), message->data, message->size);
+    return message_size;
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "renderer.h"
+#include "macros.h"
+#include "utils.h"
+
+#define HOME_AND_CLEAR "\033[H\033[2J"
+#define SAVE_CURSOR "\0337"
+#define RESTORE_CURSOR "\0338"
+#define CLEAR_LINE_END "\033[K"
+
+typedef struct {
+    const char *start;
+    size_t length;
+} Line;
+
+void screen_init(Screen *screen) {
+    screen->frame_length = 0;
+    screen->drawn = false;
+}
+
+// Splitting a frame on newlines, -1 when it has more lines than a diff can track
+static int split_lines(const char *frame, size_t frame_length, Line *lines) {
+    int count = 0;
+    const char *start = frame, *end = frame + frame_length;
+    while (start <= end) {
+        if (count == RENDER_MAX_LINES) return -1;
+        const char *newline = memchr(start, '\n', end - start);
+        const char *line_end = newline ? newline : end;
+        lines[count++] = (Line){ start, line_end - start };
+        start = line_end + 1;
+    }
+    return count;
+}
+
+static bool append(char *output, size_t output_size, size_t *length, const char *data, size_t data_length) {
+    if (*length + data_length > output_size) return false;
+    memcpy(output + *length, data, data_length);
+    *length += data_length;
+    return true;
+}
+
+// Writing the escapes that turn the last screen into this frame, 0 bytes when nothing changed.
+// The lines keep their rows as long as the frame has as many lines as the last one, otherwise,
+// or when asked to, the screen is cleared and drawn again. Lines are expected to set their own colors.
+size_t screen_diff(Screen *screen, const char *frame, size_t frame_length, bool full_redraw, char *output, size_t output_size) {
+    if (frame_length > sizeof(screen->frame)) {
+        frame_length = sizeof(screen->frame);
+    }
+
+    Line lines[RENDER_MAX_LINES], previous_lines[RENDER_MAX_LINES];
+    int count = split_lines(frame, frame_length, lines);
+    int previous_count = screen->drawn ? split_lines(screen->frame, screen->frame_length, previous_lines) : -1;
+    size_t length = 0;
+
+    if (full_redraw || count < 0 || count != previous_count) {
+        // The user's cursor ends after the last line, where the prompt is.
+        if (!append(output, output_size, &length, HOME_AND_CLEAR, strlen(HOME_AND_CLEAR)) ||
+            !append(output, output_size, &length, frame, frame_length)) {
+            length = 0;
+        }
+    } else {
+        // Drawing around the user's cursor, which stays where the user is typing.
+        bool fits = append(output, output_size, &length, SAVE_CURSOR, strlen(SAVE_CURSOR));
+        size_t changes_start = length;
+        for (int i = 0; i < count && fits; i++) {
+            if (lines[i].length == previous_lines[i].length && memcmp(lines[i].start, previous_lines[i].start, lines[i].length) == 0) {
+                continue;
+            }
+            char position[32];
+            int position_length = snprintf(position, sizeof(position), "\033[%d;1H", i + 1);
+            fits = append(output, output_size, &length, position, position_length) &&
+                   append(output, output_size, &length, lines[i].start, lines[i].length) &&
+                   append(output, output_size, &length, RESET CLEAR_LINE_END, strlen(RESET CLEAR_LINE_END));
+        }
+        if (length == changes_start) {
+            return 0;
+        }
+        fits = fits && append(output, output_size, &length, RESTORE_CURSOR, strlen(RESTORE_CURSOR));
+        if (!fits) {
+            // Too many changes for the output buffer, drawing it all again instead.
+            return screen_diff(screen, frame, frame_length, true, output, output_size);
+        }
+    }
+
+    memcpy(screen->frame, frame, frame_length);
+    screen->frame_length = frame_length;
+    screen->drawn = length > 0;
+    return length;
+}
+
+static void write_output(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written == -1 && errno == EINTR) continue;
+        if (written <= 0) return;
+        data += written;
+        length -= written;
+    }
+}
+
+static void* render_loop(void *arg) {
+    Renderer *renderer = (Renderer *)arg;
+    char frame[RENDER_FRAME_SIZE];
+    long long last_render_ms = 0;
+
+    while (1) {
+        pthread_mutex_lock(&renderer->mutex);
+        while (!renderer->dirty && !renderer->stopping) {
+            pthread_cond_wait(&renderer->changed, &renderer->mutex);
+        }
+        pthread_mutex_unlock(&renderer->mutex);
+
+        // Letting the updates of the next few milliseconds join this frame.
+        sleep_ms(last_render_ms + RENDER_INTERVAL_MS - monotonic_ms());
+
+        pthread_mutex_lock(&renderer->mutex);
+        if (renderer->stopping) {
+            pthread_mutex_unlock(&renderer->mutex);
+            break;
+        }
+        bool full_redraw = renderer->full_redraw;
+        renderer->dirty = false;
+        renderer->full_redraw = false;
+        pthread_mutex_unlock(&renderer->mutex);
+
+        size_t frame_length = renderer->compose(renderer->context, frame, sizeof(frame));
+        size_t output_length = screen_diff(&renderer->screen, frame, frame_length, full_redraw, renderer->output, sizeof(renderer->output));
+        write_output(renderer->fd, renderer->output, output_length);
+        last_render_ms = monotonic_ms();
+    }
+    return NULL;
+}
+
+Renderer* renderer_start(int fd, size_t (*compose)(void *context, char *frame, size_t size), void *context) {
+    Renderer *renderer;
+    NEW_MEMORY_ALLOCATION(renderer, sizeof(Renderer), "Failed to allocate memory for the renderer");
+    screen_init(&renderer->screen);
+    renderer->fd = fd;
+    renderer->compose = compose;
+    renderer->context = context;
+    pthread_mutex_init(&renderer->mutex, NULL);
+    pthread_cond_init(&renderer->changed, NULL);
+    renderer->dirty = false;
+    renderer->full_redraw = true;
+    renderer->stopping = false;
+
+    if (pthread_create(&renderer->thread, NULL, render_loop, renderer) != 0) {
+        handle_error(THREAD_CREATION_ERROR);
+    }
+    return renderer;
+}
+
+// Asking for a new frame, the state is read when the frame is composed
+void renderer_request(Renderer *renderer) {
+    pthread_mutex_lock(&renderer->mutex);
+    renderer->dirty = true;
+    pthread_cond_signal(&renderer->changed);
+    pthread_mutex_unlock(&renderer->mutex);
+}
+
+// Drawing the next frame from scratch, e.g. after the user's input moved the cursor
+void renderer_invalidate(Renderer *renderer) {
+    pthread_mutex_lock(&renderer->mutex);
+    renderer->full_redraw = true;
+    renderer->dirty = true;
+    pthread_cond_signal(&renderer->changed);
+    pthread_mutex_unlock(&renderer->mutex);
+}
+
+// Waiting for the frame being drawn, if any, then freeing the renderer.
+// The state the frames are composed from can be freed once this returns.
+void renderer_stop(Renderer *renderer) {
+    pthread_mutex_lock(&renderer->mutex);
+    renderer->stopping = true;
+    pthread_cond_signal(&renderer->changed);
+    pthread_mutex_unlock(&renderer->mutex);
+
+    pthread_join(renderer->thread, NULL);
+    pthread_mutex_destroy(&renderer->mutex);
+    pthread_cond_destroy(&renderer->changed);
+    free(renderer);
+}
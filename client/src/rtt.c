@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtt.h"
+#include "protocol.h"
+
+const char* rtt_request_name(char type) {
+    switch (type) {
+        case MSG_REGISTRA_UTENTE: return "registra_utente";
+        case MSG_MATRICE: return "matrice";
+        case MSG_PAROLA: return "p";
+        default: return "-";
+    }
+}
+
+static int command_index(char type) {
+    switch (type) {
+        case MSG_REGISTRA_UTENTE: return 0;
+        case MSG_MATRICE: return 1;
+        case MSG_PAROLA: return 2;
+        default: return -1;
+    }
+}
+
+void pending_ring_init(PendingRing* ring, int capacity) {
+    NEW_MEMORY_ALLOCATION(ring->requests, capacity * sizeof(PendingRequest), "Failed to allocate memory for the pending requests");
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->size = 0;
+}
+
+void pending_ring_destroy(PendingRing* ring) {
+    free(ring->requests);
+    ring->requests = NULL;
+}
+
+// Queueing a request before it's written, so its reply always finds it. false when the ring is full.
+bool pending_ring_push(PendingRing* ring, long sequence, char type, long long sent_ns) {
+    if (ring->size == ring->capacity) return false;
+    ring->requests[(ring->head + ring->size) % ring->capacity] = (PendingRequest){
+        .sequence = sequence, .type = type, .got_body = false, .got_time = false, .sent_ns = sent_ns
+    };
+    ring->size++;
+    return true;
+}
+
+// Whether the frame belongs to the request, and whether it's the last frame of its reply
+static bool owns_frame(PendingRequest* request, char type, bool* terminal) {
+    *terminal = false;
+    switch (request->type) {
+        case MSG_PAROLA:
+            *terminal = type == MSG_PUNTI_PAROLA || type == MSG_ERR;
+            return *terminal;
+        case MSG_REGISTRA_UTENTE:
+            // At most one matrix then one time left before the K, any other is a broadcast.
+            *terminal = type == MSG_OK || type == MSG_ERR;
+            if (type == MSG_MATRICE && !request->got_body && !request->got_time) {
+                request->got_body = true;
+                return true;
+            }
+            if ((type == MSG_TEMPO_PARTITA || type == MSG_TEMPO_ATTESA) && !request->got_time) {
+                request->got_time = true;
+                return true;
+            }
+            return *terminal;
+        case MSG_MATRICE:
+            if (!request->got_body) {
+                request->got_body = type == MSG_MATRICE || type == MSG_ERR;
+                return request->got_body;
+            }
+            *terminal = type == MSG_TEMPO_PARTITA || type == MSG_TEMPO_ATTESA;
+            return *terminal;
+        default:
+            return false;
+    }
+}
+
+// Values below RTT_SUB_BUCKETS get a bucket each, above that every power of two is split in RTT_SUB_BUCKETS
+static int bucket_index(unsigned long long value) {
+    if (value < RTT_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int shift = 63 - __builtin_clzll(value) - RTT_SUB_BUCKET_BITS;
+    return shift * RTT_SUB_BUCKETS + (int)(value >> shift);
+}
+
+// Exclusive upper bound of the values counted in a bucket
+static unsigned long long bucket_upper_bound(int index) {
+    if (index < RTT_SUB_BUCKETS) {
+        return index + 1;
+    }
+    int shift = index / RTT_SUB_BUCKETS - 1;
+    unsigned long long sub_bucket = index % RTT_SUB_BUCKETS + RTT_SUB_BUCKETS;
+    return (sub_bucket + 1) << shift;
+}
+
+static void record(RttHistogram* histogram, long long latency_us, bool error) {
+    if (latency_us < 0) latency_us = 0;
+    histogram->buckets[bucket_index(latency_us)]++;
+    histogram->count++;
+    histogram->errors += error;
+    histogram->sum_us += latency_us;
+    if (latency_us > histogram->max_us) histogram->max_us = latency_us;
+}
+
+// Matching a received frame to the oldest pending request, NULL when it's a push.
+// The frame ending a reply records its round trip and pops the request, which stays readable until the next push.
+PendingRequest* rtt_match_frame(PendingRing* ring, RttStats* stats, char frame_type, long long now_ns, bool* terminal) {
+    *terminal = false;
+    if (ring->size == 0) return NULL;
+
+    PendingRequest* request = &ring->requests[ring->head];
+    if (!owns_frame(request, frame_type, terminal)) return NULL;
+
+    if (*terminal) {
+        int index = command_index(request->type);
+        if (index >= 0) {
+            record(&stats->commands[index], (now_ns - request->sent_ns) / 1000, frame_type == MSG_ERR);
+        }
+        ring->head = (ring->head + 1) % ring->capacity;
+        ring->size--;
+    }
+    return request;
+}
+
+// Upper bound of the bucket holding the quantile, so the result overestimates by at most one bucket width
+long long rtt_quantile(const RttHistogram* histogram, double quantile) {
+    if (histogram->count == 0) return 0;
+
+    long target = (long)(quantile * histogram->count);
+    if (target >= histogram->count) target = histogram->count - 1;
+    long seen = 0;
+    for (int i = 0; i < RTT_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen > target) {
+            long long bound = bucket_upper_bound(i);
+            return bound < histogram->max_us ? bound : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+// One line per command: replies, errors and round trip percentiles in microseconds
+void rtt_format(const RttStats* stats, TextBuffer* text) {
+    text_append(text, "%-16s %7s %7s %9s %9s %9s %9s %9s\n",
+                "request", "replies", "errors", "mean_us", "p50_us", "p90_us", "p99_us", "max_us");
+    const char types[RTT_COMMANDS] = { MSG_REGISTRA_UTENTE, MSG_MATRICE, MSG_PAROLA };
+    for (int i = 0; i < RTT_COMMANDS; i++) {
+        const RttHistogram* histogram = &stats->commands[i];
+        text_append(text, "%-16s %7ld %7ld %9lld %9lld %9lld %9lld %9lld\n",
+                    rtt_request_name(types[i]), histogram->count, histogram->errors,
+                    histogram->count ? histogram->sum_us / histogram->count : 0,
+                    rtt_quantile(histogram, 0.50), rtt_quantile(histogram, 0.90),
+                    rtt_quantile(histogram, 0.99), histogram->max_us);
+    }
+}
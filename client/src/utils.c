@@ -1,10 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 
 #include <macros.h>
 #include <utils.h>
 
+#define TITLE_BUFFER_SIZE 1024
+
 // Get rid of newline character at the end of a string
 void trim_newline(char *str) {
     char *pos;
@@ -13,6 +17,25 @@ void trim_newline(char *str) {
     }
 }
 
+long long monotonic_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+long long monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Sleeping the whole duration even when signals interrupt it, nothing for a duration <= 0
+void sleep_ms(long long duration_ms) {
+    if (duration_ms <= 0) return;
+    struct timespec pause = { duration_ms / 1000, (duration_ms % 1000) * 1000000L };
+    while (nanosleep(&pause, &pause) == -1 && errno == EINTR);
+}
+
 void handle_error(Error err) {
     if (err.code != 0) {        // 0 is success
         fprintf(stderr, "Error [%d]: %s\n", err.code, err.message);
@@ -20,33 +43,44 @@ void handle_error(Error err) {
     }
 }
 
-void print_title(char *title) {
+// Appending formatted text, the buffer always stays terminated
+void text_append(TextBuffer *text, const char *format, ...) {
+    if (text->length + 1 >= text->size) return;
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vsnprintf(text->data + text->length, text->size - text->length, format, arguments);
+    va_end(arguments);
+    if (written < 0) return;
+    text->length += (size_t)written < text->size - text->length ? (size_t)written : text->size - text->length - 1;
+}
+
+void format_title(TextBuffer *text, const char *title) {
     int title_length = strlen(title);
     int padding = 2; // padding on each side of the title
     int total_length = title_length + 2 * padding;
 
     // Top part
-    printf("\n   " BOX_TOP_LEFT);
+    text_append(text, "\n   " BOX_TOP_LEFT);
     for (int i = 0; i < total_length; i++) {
-        printf(BOX_HORIZONTAL);
+        text_append(text, BOX_HORIZONTAL);
     }
-    printf(BOX_TOP_RIGHT "\n");
+    text_append(text, BOX_TOP_RIGHT "\n");
 
     // Middle part
-    printf("   " BOX_VERTICAL);
-    for (int i = 0; i < padding; i++) {
-        printf(" ");
-    }
-    printf(BOLD "%s" RESET, title);
-    for (int i = 0; i < padding; i++) {
-        printf(" ");
-    }
-    printf(BOX_VERTICAL "\n");
+    text_append(text, "   " BOX_VERTICAL "%*s" BOLD "%s" RESET "%*s" BOX_VERTICAL "\n", padding, "", title, padding, "");
 
     // Bottom part
-    printf("   " BOX_BOTTOM_LEFT);
+    text_append(text, "   " BOX_BOTTOM_LEFT);
     for (int i = 0; i < total_length; i++) {
-        printf(BOX_HORIZONTAL);
+        text_append(text, BOX_HORIZONTAL);
     }
-    printf(BOX_BOTTOM_RIGHT "\n\n\n");
-}
\ No newline at end of file
+    text_append(text, BOX_BOTTOM_RIGHT "\n\n\n");
+}
+
+void print_title(char *title) {
+    char data[TITLE_BUFFER_SIZE];
+    TextBuffer text = { data, sizeof(data), 0 };
+    data[0] = '\0';
+    format_title(&text, title);
+    fputs(data, stdout);
+}
@@ -0,0 +1,543 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "macros.h"
+#include "utils.h"
+#include "protocol.h"
+#include "matrix_handler.h"
+
+// Headless load generator: opens many connections to paroliere_srv, registers a user on each
+// and then requests matrices and submits words at fixed rates, one request in flight per connection.
+// Words are picked among the dictionary words traceable on the connection's last board, --garbage percent
+// of them are random letters instead, which the server rejects.
+// Usage: ./executables/paroliere_load server_name server_port [--connections n] [--duration seconds]
+//        [--word-rate per_second] [--matrix-rate per_second] [--diz dictionary_file] [--garbage percent] [--seed n]
+
+#define READ_BUFFER_SIZE 8192
+#define TICK_MS 5
+#define MAX_EVENTS 256
+#define TRACKED_TYPES 3 // Requests we time: registration, matrix, word
+
+typedef enum {
+    CONN_CONNECTING,
+    CONN_REGISTERING,
+    CONN_RUNNING,
+    CONN_CLOSED
+} ConnectionState;
+
+typedef struct {
+    int fd;
+    int id;
+    ConnectionState state;
+    char read_buffer[READ_BUFFER_SIZE];
+    size_t read_length;
+    char pending_type;           // Request waiting for its reply, 0 if none
+    long long pending_since_ns;
+    bool pending_has_body;       // The matrix (or error) of a pending matrice reply came, its time frame ends it
+    bool pending_failed;
+    bool has_board;
+    Cell board[MATRIX_SIZE][MATRIX_SIZE]; // Last matrix received, as a reply or a push
+    long long next_word_ns;
+    long long next_matrix_ns;
+} LoadConnection;
+
+typedef struct {
+    char type;
+    const char* name;
+    long sent;
+    long replies;
+    long errors;
+    unsigned int* latencies_us;
+    size_t latencies_size;
+    size_t latencies_capacity;
+} RequestStats;
+
+typedef struct {
+    char* server_name;
+    int server_port;
+    int connections;
+    double duration_s;
+    double word_rate;
+    double matrix_rate;
+    char* dictionary_file;
+    int garbage_percent;
+    unsigned int seed;
+} LoadOptions;
+
+typedef struct {
+    char** words;
+    size_t size;
+} WordList;
+
+// The dictionary words traceable on a board. Every connection plays the same round, so it's only rebuilt for a new matrix.
+typedef struct {
+    Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
+    size_t* words; // Indices in the WordList
+    size_t size;
+    bool built;
+} BoardWords;
+
+static RequestStats stats[TRACKED_TYPES] = {
+    { .type = MSG_REGISTRA_UTENTE, .name = "registra_utente" },
+    { .type = MSG_MATRICE, .name = "matrice" },
+    { .type = MSG_PAROLA, .name = "parola" }
+};
+static long unsolicited[256];
+static long failed_connections = 0;
+static BoardWords board_words;
+
+static long long now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static RequestStats* stats_for(char type) {
+    for (int i = 0; i < TRACKED_TYPES; i++) {
+        if (stats[i].type == type) return &stats[i];
+    }
+    return NULL;
+}
+
+static void record_latency(RequestStats* request_stats, long long latency_ns) {
+    if (request_stats->latencies_size == request_stats->latencies_capacity) {
+        request_stats->latencies_capacity = request_stats->latencies_capacity ? request_stats->latencies_capacity * 2 : 1024;
+        request_stats->latencies_us = realloc(request_stats->latencies_us, request_stats->latencies_capacity * sizeof(unsigned int));
+        if (!request_stats->latencies_us) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+    }
+    request_stats->latencies_us[request_stats->latencies_size++] = (unsigned int)(latency_ns / 1000);
+}
+
+// Loading the words the server could accept, the rest of the dictionary is useless for the board
+static WordList load_words(const char* filename) {
+    WordList list = {0};
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+
+    size_t capacity = 1024;
+    list.words = malloc(capacity * sizeof(char*));
+    char line[256];
+    while (list.words && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0'; // The shipped dictionary has CRLF line endings
+        size_t length = strlen(line);
+        if (length < 4 || length > MAX_WORD_LENGTH) continue;
+
+        if (list.size == capacity) {
+            capacity *= 2;
+            list.words = realloc(list.words, capacity * sizeof(char*));
+            if (!list.words) break;
+        }
+        list.words[list.size++] = strdup(line);
+    }
+    fclose(file);
+
+    if (!list.words || list.size == 0) {
+        handle_error(FILE_SIZE_ERROR);
+    }
+    return list;
+}
+
+static void raise_fd_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void close_connection(LoadConnection* connection, int epoll_fd) {
+    if (connection->state == CONN_CLOSED) return;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->state = CONN_CLOSED;
+}
+
+// Packing the request with the client code and sending it, one request is in flight at a time
+static bool send_request(LoadConnection* connection, char type, const char* content, int epoll_fd) {
+    Message message = { .type = type, .size = strlen(content), .data = (char*)content };
+    char* buffer = NULL;
+    int message_size = pack_message(&message, &buffer);
+
+    ssize_t written = write(connection->fd, buffer, message_size);
+    free(buffer);
+    if (written != message_size) {
+        failed_connections++;
+        close_connection(connection, epoll_fd);
+        return false;
+    }
+
+    connection->pending_type = type;
+    connection->pending_since_ns = now_ns();
+    connection->pending_has_body = false;
+    connection->pending_failed = false;
+    stats_for(type)->sent++;
+    return true;
+}
+
+static bool is_time_frame(char type) {
+    return type == MSG_TEMPO_PARTITA || type == MSG_TEMPO_ATTESA;
+}
+
+// Whether the frame belongs to the pending request's reply, and whether it's the reply's last frame.
+// A registration gets the matrix (during a game) and the time left before its K, a matrice its matrix or error then the time left.
+static bool belongs_to_reply(LoadConnection* connection, char type, bool* last) {
+    *last = false;
+    switch (connection->pending_type) {
+        case MSG_REGISTRA_UTENTE:
+            *last = type == MSG_OK || type == MSG_ERR;
+            return *last || type == MSG_MATRICE || is_time_frame(type);
+        case MSG_MATRICE:
+            if (!connection->pending_has_body) {
+                connection->pending_has_body = type == MSG_MATRICE || type == MSG_ERR;
+                connection->pending_failed = type == MSG_ERR;
+                return connection->pending_has_body;
+            }
+            *last = is_time_frame(type);
+            return *last;
+        case MSG_PAROLA:
+            *last = type == MSG_PUNTI_PAROLA || type == MSG_ERR;
+            return *last;
+        default:
+            return false;
+    }
+}
+
+// Matching a frame to the pending request, anything else is a push from the server
+static void handle_reply(LoadConnection* connection, const Message* message) {
+    if (message->type == MSG_MATRICE && message->size == MATRIX_BYTES) {
+        memcpy(connection->board, message->data, MATRIX_BYTES);
+        connection->has_board = true;
+    }
+
+    bool last;
+    if (!belongs_to_reply(connection, message->type, &last)) {
+        unsolicited[(unsigned char)message->type]++;
+        return;
+    }
+    if (!last) return;
+
+    char pending = connection->pending_type;
+    RequestStats* request_stats = stats_for(pending);
+    request_stats->replies++;
+    if (message->type == MSG_ERR || connection->pending_failed) {
+        request_stats->errors++;
+    }
+    record_latency(request_stats, now_ns() - connection->pending_since_ns);
+    connection->pending_type = 0;
+
+    if (pending == MSG_REGISTRA_UTENTE) {
+        connection->state = CONN_RUNNING;
+    }
+}
+
+// Reading what's available and handing every complete frame to the client's interpret_message
+static void read_frames(LoadConnection* connection, int epoll_fd) {
+    while (1) {
+        ssize_t bytes_read = read(connection->fd, connection->read_buffer + connection->read_length,
+                                  READ_BUFFER_SIZE - connection->read_length);
+        if (bytes_read == 0 || (bytes_read < 0 && errno != EAGAIN && errno != EINTR)) {
+            failed_connections++;
+            close_connection(connection, epoll_fd);
+            return;
+        }
+        if (bytes_read < 0) break;
+        connection->read_length += bytes_read;
+
+        size_t offset = 0;
+        while (connection->read_length - offset >= sizeof(int)) {
+            int frame_length;
+            memcpy(&frame_length, connection->read_buffer + offset, sizeof(int));
+            if (frame_length < (int)(sizeof(char) + sizeof(int)) || frame_length > READ_BUFFER_SIZE - (int)sizeof(int)) {
+                failed_connections++;
+                close_connection(connection, epoll_fd);
+                return;
+            }
+            if (connection->read_length - offset < sizeof(int) + frame_length) break;
+
+            Message message = interpret_message(connection->read_buffer + offset + sizeof(int));
+            handle_reply(connection, &message);
+            free(message.data);
+            offset += sizeof(int) + frame_length;
+        }
+
+        memmove(connection->read_buffer, connection->read_buffer + offset, connection->read_length - offset);
+        connection->read_length -= offset;
+    }
+}
+
+static void open_connection(LoadConnection* connection, int id, struct sockaddr_in* server_addr, int epoll_fd) {
+    connection->id = id;
+    connection->read_length = 0;
+    connection->pending_type = 0;
+    connection->has_board = false;
+    connection->state = CONN_CLOSED;
+
+    connection->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (connection->fd < 0) {
+        failed_connections++;
+        return;
+    }
+
+    int flag = 1;
+    setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    if (connect(connection->fd, (struct sockaddr*)server_addr, sizeof(*server_addr)) < 0 && errno != EINPROGRESS) {
+        failed_connections++;
+        close(connection->fd);
+        return;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN | EPOLLOUT, .data.ptr = connection };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection->fd, &event);
+    connection->state = CONN_CONNECTING;
+}
+
+// Sending the registration once the non-blocking connect is done
+static void finish_connect(LoadConnection* connection, int epoll_fd) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error != 0) {
+        failed_connections++;
+        close_connection(connection, epoll_fd);
+        return;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+
+    char username[16];
+    snprintf(username, sizeof(username), "lg%d", connection->id);
+    connection->state = CONN_REGISTERING;
+    send_request(connection, MSG_REGISTRA_UTENTE, username, epoll_fd);
+}
+
+static void random_garbage_word(char* word, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        word[i] = 'a' + rand() % 26;
+    }
+    word[length] = '\0';
+}
+
+// Collecting the words traceable on the board, unless it's the one the list was built for
+static void build_board_words(Cell board[MATRIX_SIZE][MATRIX_SIZE], const WordList* words) {
+    if (board_words.built && memcmp(board_words.matrix, board, MATRIX_BYTES) == 0) return;
+
+    if (!board_words.words) {
+        board_words.words = malloc(words->size * sizeof(size_t));
+        if (!board_words.words) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+    }
+    memcpy(board_words.matrix, board, MATRIX_BYTES);
+    board_words.size = 0;
+    for (size_t i = 0; i < words->size; i++) {
+        if (can_trace_word(board, words->words[i])) {
+            board_words.words[board_words.size++] = i;
+        }
+    }
+    board_words.built = true;
+}
+
+// A word the server should accept on the connection's board, any dictionary word before a board is known
+static const char* pick_word(LoadConnection* connection, const WordList* words) {
+    if (connection->has_board) {
+        build_board_words(connection->board, words);
+        if (board_words.size > 0) {
+            return words->words[board_words.words[rand() % board_words.size]];
+        }
+    }
+    return words->words[rand() % words->size];
+}
+
+// Sending the next due request of a running connection, if it has nothing in flight
+static void schedule_requests(LoadConnection* connection, const LoadOptions* options, const WordList* words, long long now, int epoll_fd) {
+    if (connection->state != CONN_RUNNING || connection->pending_type != 0) return;
+
+    if (options->matrix_rate > 0 && now >= connection->next_matrix_ns) {
+        long long interval = (long long)(1e9 / options->matrix_rate);
+        connection->next_matrix_ns = connection->next_matrix_ns + interval > now ? connection->next_matrix_ns + interval : now + interval;
+        send_request(connection, MSG_MATRICE, "", epoll_fd);
+    } else if (options->word_rate > 0 && now >= connection->next_word_ns) {
+        long long interval = (long long)(1e9 / options->word_rate);
+        connection->next_word_ns = connection->next_word_ns + interval > now ? connection->next_word_ns + interval : now + interval;
+
+        char garbage[MAX_WORD_LENGTH + 1];
+        const char* word = pick_word(connection, words);
+        if (rand() % 100 < options->garbage_percent) {
+            random_garbage_word(garbage, 4 + rand() % 6);
+            word = garbage;
+        }
+        send_request(connection, MSG_PAROLA, word, epoll_fd);
+    }
+}
+
+static int compare_latencies(const void* a, const void* b) {
+    unsigned int latency_a = *(const unsigned int*)a;
+    unsigned int latency_b = *(const unsigned int*)b;
+    return (latency_a > latency_b) - (latency_a < latency_b);
+}
+
+static unsigned int percentile(const RequestStats* request_stats, double fraction) {
+    if (request_stats->latencies_size == 0) return 0;
+    size_t index = (size_t)(fraction * (request_stats->latencies_size - 1));
+    return request_stats->latencies_us[index];
+}
+
+static void print_report(const LoadOptions* options, double elapsed_s, int connected) {
+    printf("\nLoad test: %d/%d connections registered, %.1f s\n", connected, options->connections, elapsed_s);
+    printf("%-16s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+           "request", "sent", "replies", "errors", "ops/s", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+
+    for (int i = 0; i < TRACKED_TYPES; i++) {
+        RequestStats* request_stats = &stats[i];
+        qsort(request_stats->latencies_us, request_stats->latencies_size, sizeof(unsigned int), compare_latencies);
+        printf("%-16s %10ld %10ld %10ld %10.1f %10u %10u %10u %10u %10u\n",
+               request_stats->name, request_stats->sent, request_stats->replies, request_stats->errors,
+               request_stats->replies / elapsed_s,
+               percentile(request_stats, 0.50), percentile(request_stats, 0.90),
+               percentile(request_stats, 0.99), percentile(request_stats, 0.999),
+               percentile(request_stats, 1.0));
+    }
+
+    printf("\nPushed by the server:");
+    for (int type = 0; type < 256; type++) {
+        if (unsolicited[type] > 0) printf(" %c=%ld", type, unsolicited[type]);
+    }
+    printf("\nFailed or dropped connections: %ld\n", failed_connections);
+}
+
+static void parse_options(int argc, char* argv[], LoadOptions* options) {
+    if (argc < 3) {
+        handle_error(WRONG_PARAMS_ERROR);
+    }
+
+    options->server_name = argv[1];
+    options->server_port = atoi(argv[2]);
+    options->connections = 100;
+    options->duration_s = 30;
+    options->word_rate = 1;
+    options->matrix_rate = 0.1;
+    options->dictionary_file = "../server/data/dictionary_ita.txt";
+    options->garbage_percent = 10;
+    options->seed = (unsigned int)time(NULL);
+
+    static struct option long_opts[] = {
+        {"connections", required_argument, NULL, 'c'},
+        {"duration",    required_argument, NULL, 'd'},
+        {"word-rate",   required_argument, NULL, 'w'},
+        {"matrix-rate", required_argument, NULL, 'm'},
+        {"diz",         required_argument, NULL, 'z'},
+        {"garbage",     required_argument, NULL, 'g'},
+        {"seed",        required_argument, NULL, 's'},
+        {0, 0, 0, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "c:d:w:m:z:g:s:", long_opts, NULL)) != -1) {
+        switch (option) {
+            case 'c': options->connections = atoi(optarg); break;
+            case 'd': options->duration_s = atof(optarg); break;
+            case 'w': options->word_rate = atof(optarg); break;
+            case 'm': options->matrix_rate = atof(optarg); break;
+            case 'z': options->dictionary_file = optarg; break;
+            case 'g': options->garbage_percent = atoi(optarg); break;
+            case 's': options->seed = (unsigned int)atoi(optarg); break;
+            default: handle_error(WRONG_PARAMS_ERROR);
+        }
+    }
+
+    if (options->connections <= 0 || options->duration_s <= 0 || options->word_rate < 0 || options->matrix_rate < 0) {
+        handle_error(NEGATIVE_PARAM_ERROR);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    parse_options(argc, argv, &options);
+    srand(options.seed);
+    raise_fd_limit();
+
+    WordList words = load_words(options.dictionary_file);
+    printf("Loaded %zu candidate words, opening %d connections to %s:%d\n",
+           words.size, options.connections, options.server_name, options.server_port);
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(options.server_port);
+    const char* address = strcmp(options.server_name, "localhost") == 0 ? "127.0.0.1" : options.server_name;
+    if (inet_pton(AF_INET, address, &server_addr.sin_addr) <= 0) {
+        handle_error(SERVER_NAME_ERROR);
+    }
+
+    int epoll_fd;
+    SYSC(epoll_fd, epoll_create1(0), "epoll creation failed");
+
+    LoadConnection* connections = calloc(options.connections, sizeof(LoadConnection));
+    if (!connections) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+
+    long long start = now_ns();
+    for (int i = 0; i < options.connections; i++) {
+        open_connection(&connections[i], i, &server_addr, epoll_fd);
+        // Spreading the first requests so the connections don't all fire on the same tick.
+        connections[i].next_word_ns = start + (options.word_rate > 0 ? rand() % (long long)(1e9 / options.word_rate) : 0);
+        connections[i].next_matrix_ns = start + (options.matrix_rate > 0 ? rand() % (long long)(1e9 / options.matrix_rate) : 0);
+    }
+
+    long long end = start + (long long)(options.duration_s * 1e9);
+    struct epoll_event events[MAX_EVENTS];
+    long long now;
+
+    while ((now = now_ns()) < end) {
+        int ready = epoll_wait(epoll_fd, events, MAX_EVENTS, TICK_MS);
+        for (int i = 0; i < ready; i++) {
+            LoadConnection* connection = events[i].data.ptr;
+            if (connection->state == CONN_CONNECTING && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                finish_connect(connection, epoll_fd);
+            } else if (connection->state != CONN_CLOSED && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+                read_frames(connection, epoll_fd);
+            }
+        }
+
+        now = now_ns();
+        for (int i = 0; i < options.connections; i++) {
+            schedule_requests(&connections[i], &options, &words, now, epoll_fd);
+        }
+    }
+
+    int connected = 0;
+    for (int i = 0; i < options.connections; i++) {
+        if (connections[i].state == CONN_RUNNING) connected++;
+        close_connection(&connections[i], epoll_fd);
+    }
+
+    print_report(&options, (now_ns() - start) / 1e9, connected);
+
+    for (size_t i = 0; i < words.size; i++) free(words.words[i]);
+    free(board_words.words);
+    free(words.words);
+    for (int i = 0; i < TRACKED_TYPES; i++) free(stats[i].latencies_us);
+    free(connections);
+    close(epoll_fd);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+# PGO training session for the client: starts a local server and runs a scripted headless session against it.
+# Registration, pipelined matrices and words during the waiting phase, then again once the round has started,
+# so the reply matching and the frame reading see every kind of frame the server sends.
+# Usage (from the client directory): tools/pgo_session.sh <client executable> [port]
+set -e
+
+CLIENT=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+PORT=${2:-8997}
+WAITING_MS=20500 # Past the server's first waiting phase (WAITING_DURATION)
+WORDS=$(tr -d '\r' < ../server/data/dictionary_ita.txt | awk 'length($0) >= 4 && NR % 1499 == 0')
+
+# The server's release profile, it runs from its own directory for its dictionary and config.
+MAKEFLAGS= make -s -C ../server release > /dev/null # Not with the client make's variables
+SERVER_LOG=$(mktemp)
+(cd ../server && exec ./executables/release/paroliere_srv localhost "$PORT" --durata 0.5) > "$SERVER_LOG" 2>&1 &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null; rm -f "$SERVER_LOG"' EXIT
+
+# The server listens once its dictionary is loaded.
+tries=0
+until grep -q "listening" "$SERVER_LOG"; do
+    tries=$((tries + 1))
+    [ $tries -le 100 ] || { echo "The training server didn't start" >&2; exit 1; }
+    sleep 0.1
+done
+
+session() {
+    echo "registra_utente pgo"
+    echo "wait"
+    for phase in waiting game; do
+        echo "matrice"
+        for word in $WORDS; do
+            echo "p $word"
+        done
+        echo "matrice"
+        echo "wait"
+        echo "stats"
+        [ $phase = waiting ] && echo "sleep $WAITING_MS"
+    done
+    echo "fine"
+}
+
+session | "$CLIENT" localhost "$PORT" --script - --inflight 32 > /dev/null
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "matrix_handler.h"
+#include "player_handler.h"
+#include "macros.h"
+#include "utils.h"
+#include "room.h"
+#include "verdict_cache.h"
+#include "bench_harness.h"
+
+// Microbenchmarks for the server hot paths, linked against the server objects.
+// Usage (from the server directory): ./executables/paroliere_bench [--repeat n] [--save file] [--compare file] [name_filter]
+
+#define INPUT_COUNT 4096 // Power of two, inputs are picked with i & INPUT_MASK
+#define INPUT_MASK (INPUT_COUNT - 1)
+#define BENCH_PLAYERS 1024
+#define BENCH_DICTIONARY_FILE "./data/dictionary_ita.txt"
+#define BENCH_MATRIX_FILE "./data/matrix.txt"
+#define BENCH_SEED 42
+
+// Inputs shared by the kernels, built once before timing anything
+static TrieNode* dictionary;
+static char* dictionary_words[INPUT_COUNT];
+static char* random_words[INPUT_COUNT];
+static Cell (*boards)[MATRIX_SIZE][MATRIX_SIZE];
+static int board_count;
+static int board_hit_boards[INPUT_COUNT];
+static char* board_hit_words[INPUT_COUNT];
+static int board_hit_count;
+static Message word_messages[INPUT_COUNT];
+static char serialized_messages[INPUT_COUNT][MAX_BUFFER_SIZE];
+static int serialized_sizes[INPUT_COUNT];
+static PlayerArray* registry;
+static int player_fds[INPUT_COUNT];
+
+static VerdictCache* verdict_cache;
+
+static Room* bench_room;
+static sem_t room_drained;
+
+static volatile long sink; // Keeps the compiler from dropping the kernels' results
+static FILE* report;
+
+static void bench_dictionary_hit(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        sink += is_word_in_dictionary(dictionary, dictionary_words[i & INPUT_MASK]);
+    }
+}
+
+static void bench_dictionary_miss(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        sink += is_word_in_dictionary(dictionary, random_words[i & INPUT_MASK]);
+    }
+}
+
+// Every word was looked up once already, so this is the probe that replaces the trie walk
+static void bench_dictionary_cache_hit(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        bool in_dictionary = false;
+        sink += verdict_cache_lookup(verdict_cache, dictionary_words[i & INPUT_MASK], &in_dictionary);
+        sink += in_dictionary;
+    }
+}
+
+static void bench_matrix_hit(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        int input = i % board_hit_count;
+        sink += is_word_in_matrix(boards[board_hit_boards[input]], board_hit_words[input]);
+    }
+}
+
+static void bench_matrix_miss(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        sink += is_word_in_matrix(boards[i % board_count], dictionary_words[i & INPUT_MASK]);
+    }
+}
+
+static void bench_serialize_message(long iterations) {
+    char buffer[MAX_BUFFER_SIZE];
+    for (long i = 0; i < iterations; i++) {
+        sink += serialize_message(&word_messages[i & INPUT_MASK], buffer, sizeof(buffer));
+    }
+}
+
+static void bench_deserialize_message(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        int input = i & INPUT_MASK;
+        Message message;
+        sink += deserialize_message(serialized_messages[input], serialized_sizes[input], &message);
+        sink += message.size;
+    }
+}
+
+static void bench_find_player(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        sink += find_player(registry, player_fds[i & INPUT_MASK])->fd;
+    }
+}
+
+// An empty room: what's measured is the queue handoff and the room loop, in events handled per second
+static void bench_room_event(RoomEvent* event) {
+    if (event->data) {
+        sem_post((sem_t*)event->data);
+    }
+}
+
+static long long bench_room_no_tick() { return -1; }
+static void bench_room_tick() {}
+
+// Posting from this thread and waiting for the room to have handled the last event
+static void bench_room_events(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        room_post(bench_room, 0, NULL);
+    }
+    room_post(bench_room, 0, &room_drained);
+    while (sem_wait(&room_drained) == -1);
+}
+
+static const Benchmark benchmarks[] = {
+    { "dictionary_hit", bench_dictionary_hit },
+    { "dictionary_miss", bench_dictionary_miss },
+    { "dictionary_cache_hit", bench_dictionary_cache_hit },
+    { "matrix_hit", bench_matrix_hit },
+    { "matrix_miss", bench_matrix_miss },
+    { "serialize_message", bench_serialize_message },
+    { "deserialize_message", bench_deserialize_message },
+    { "find_player", bench_find_player },
+    { "room_events", bench_room_events },
+};
+
+// The server code logs on stdout, results go to a copy of the original stdout instead
+static void redirect_stdout() {
+    fflush(stdout);
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (!report || devnull == -1) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+}
+
+static char** load_lines(const char* filename, int* count) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+
+    int capacity = 1024;
+    char** lines = malloc(capacity * sizeof(char*));
+    char line[256];
+    *count = 0;
+    while (lines && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0'; // The shipped dictionary has CRLF line endings
+        if (line[0] == '\0') continue;
+        if (*count == capacity) {
+            capacity *= 2;
+            lines = realloc(lines, capacity * sizeof(char*));
+            if (!lines) break;
+        }
+        lines[(*count)++] = strdup(line);
+    }
+    fclose(file);
+
+    if (!lines || *count == 0) {
+        handle_error(FILE_SIZE_ERROR);
+    }
+    return lines;
+}
+
+static void prepare_words(char** lines, int line_count) {
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        dictionary_words[i] = lines[rand() % line_count];
+
+        int length = 4 + rand() % 7;
+        random_words[i] = malloc(length + 1);
+        for (int j = 0; j < length; j++) {
+            random_words[i][j] = 'a' + rand() % 26;
+        }
+        random_words[i][length] = '\0';
+    }
+}
+
+// Loading every board of the matrix file and collecting dictionary words that can be formed on them
+static void prepare_boards(char** lines, int line_count) {
+    char** board_lines = load_lines(BENCH_MATRIX_FILE, &board_count);
+    boards = malloc(board_count * sizeof(*boards));
+    if (!boards) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    for (int i = 0; i < board_count; i++) {
+        init_matrix_from_file(boards[i], BENCH_MATRIX_FILE, i);
+        free(board_lines[i]);
+    }
+    free(board_lines);
+
+    for (int i = 0; i < line_count && board_hit_count < INPUT_COUNT; i++) {
+        int board = i % board_count;
+        if (is_word_in_matrix(boards[board], lines[i])) {
+            board_hit_boards[board_hit_count] = board;
+            board_hit_words[board_hit_count++] = lines[i];
+        }
+    }
+    if (board_hit_count == 0) {
+        handle_error(FILE_SIZE_ERROR);
+    }
+}
+
+static void prepare_verdict_cache() {
+    verdict_cache = verdict_cache_create(DEFAULT_DICTIONARY_CACHE_ENTRIES);
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        verdict_cache_insert(verdict_cache, dictionary_words[i], is_word_in_dictionary(dictionary, dictionary_words[i]));
+    }
+}
+
+static void prepare_messages() {
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        word_messages[i].type = MSG_PAROLA;
+        word_messages[i].size = strlen(dictionary_words[i]);
+        word_messages[i].data = dictionary_words[i];
+        serialized_sizes[i] = serialize_message(&word_messages[i], serialized_messages[i], MAX_BUFFER_SIZE);
+    }
+}
+
+static void prepare_registry() {
+    registry = create_player_registry(BENCH_PLAYERS);
+    for (int i = 0; i < BENCH_PLAYERS; i++) {
+        char username[MAX_USERNAME_LENGTH];
+        snprintf(username, sizeof(username), "b%d", i);
+        add_player(registry, create_player(i + 3), username);
+    }
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        player_fds[i] = 3 + rand() % BENCH_PLAYERS;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    parse_bench_options(argc, argv, &options);
+
+    redirect_stdout();
+    srand(BENCH_SEED);
+
+    int line_count;
+    char** lines = load_lines(BENCH_DICTIONARY_FILE, &line_count);
+    dictionary = init_dictionary(BENCH_DICTIONARY_FILE);
+    prepare_words(lines, line_count);
+    prepare_boards(lines, line_count);
+    prepare_verdict_cache();
+    prepare_messages();
+    prepare_registry();
+    sem_init(&room_drained, 0, 0);
+    bench_room = room_create(bench_room_event, bench_room_no_tick, bench_room_tick);
+
+    int result = run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]), &options, report);
+
+    fclose(report);
+    return result;
+}
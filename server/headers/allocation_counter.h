@@ -0,0 +1,22 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Opt-in with -DALLOCATION_COUNTING=1, only make sim and make bench pass it: the allocator entry points are then
+// wrapped around glibc's own implementations to count the heap allocations of each thread. strdup and the other
+// glibc functions that allocate call the wrapped malloc, so they're counted too. Every other build keeps the
+// normal allocator and counts nothing, as do sanitizer builds, which bring their own.
+#ifndef ALLOCATION_COUNTING
+#define ALLOCATION_COUNTING 0
+#endif
+#if ALLOCATION_COUNTING && (defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__))
+#undef ALLOCATION_COUNTING
+#define ALLOCATION_COUNTING 0
+#endif
+
+long thread_allocations();
+void thread_allocations_add(long count);
+
+#endif
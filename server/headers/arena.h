@@ -0,0 +1,41 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "macros.h"
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 16
+
+// A chunk of memory owned by an arena, allocations are carved from data[] sequentially
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t capacity;
+    size_t used;
+    char data[];
+} ArenaChunk;
+
+// Bump allocator for round-scoped data: everything is released at once by arena_reset.
+// Chunks are kept across resets, so a steady-state round allocates nothing from the heap.
+// Not locked: one thread allocates and resets (the room's), others may only read the byte counts.
+typedef struct {
+    ArenaChunk *first;
+    ArenaChunk *current;
+    size_t chunk_size;
+    atomic_size_t bytes_used;
+    atomic_size_t bytes_reserved;
+} Arena;
+
+Arena* arena_create(size_t chunk_size);
+void* arena_alloc(Arena* arena, size_t size);
+char* arena_strdup(Arena* arena, const char* str);
+void arena_reset(Arena* arena);
+void arena_destroy(Arena* arena);
+size_t arena_bytes_used(Arena* arena);
+size_t arena_bytes_reserved(Arena* arena);
+
+#endif
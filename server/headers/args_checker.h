@@ -10,9 +10,10 @@
 #include <time.h>
 
 #include <macros.h>
+#include "simulation.h"
 
 #define DEFAULT_DURATION 180
 
-void handle_args(int argc, char *argv[], char **serverName, int *serverPort, unsigned int *rndSeed, float *gameDuration, char **matrixFilename, char **newDictionaryFile);
+void handle_args(int argc, char *argv[], char **serverName, int *serverPort, unsigned int *rndSeed, float *gameDuration, int *waitingDuration, char **matrixFilename, char **newDictionaryFile, SimulationOptions *simulation);
 
 #endif
\ No newline at end of file
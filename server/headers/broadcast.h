@@ -0,0 +1,62 @@
+#ifndef BROADCAST_H
+#define BROADCAST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <poll.h>
+#include <semaphore.h>
+
+#include "player_handler.h"
+#include "mpmc_queue.h"
+#include "metrics.h"
+
+#define BROADCAST_TIMEOUT_MS 500 // A player that can't take its frames within this is disconnected
+#define BROADCAST_BATCHES 64     // Broadcasts waiting for the sender at most, the poster only waits past that
+
+typedef struct {
+    Player *player;
+    const char *data;  // Complete frames, written as one unit under the player's send lock
+    size_t size;
+    size_t sent;
+    bool locked;       // Holding the player's send lock
+    bool done;
+} BroadcastTarget;
+
+// Frames for a snapshot of the players, written after the registry lock is released.
+// Sockets are written without blocking and polled together against one deadline, so a client
+// that stops reading delays a broadcast by BROADCAST_TIMEOUT_MS at most, and only once.
+typedef struct {
+    BroadcastTarget *targets;
+    struct pollfd *pollfds;
+    int size;
+    int capacity;
+} Broadcast;
+
+// One broadcast handed to the sender thread, with its own copy of the frames. Batches are reused once sent.
+typedef struct {
+    Broadcast broadcast;
+    char *data;
+    size_t size;
+    size_t capacity;
+} BroadcastBatch;
+
+// A thread writing the broadcasts posted by one other thread (the room), in the order they were posted.
+// Posting copies the frames and links the batch through lock-free queues: the poster never waits on a socket.
+typedef struct {
+    MpmcQueue *pending;  // Posted, not sent yet
+    MpmcQueue *spare;    // Sent, ready to be reused
+    sem_t ready;         // One post per pending batch
+    sem_t spares;        // One post per spare batch
+    int batches;         // Allocated so far, only touched by the poster
+    Metric *slow_clients;
+} BroadcastSender;
+
+void broadcast_add(Broadcast *broadcast, Player *player, const char *data, size_t size);
+int broadcast_send(Broadcast *broadcast);
+BroadcastSender* create_broadcast_sender(Metric *slow_clients);
+BroadcastBatch* broadcast_batch(BroadcastSender *sender, const char *frames, size_t size);
+void broadcast_batch_add(BroadcastBatch *batch, Player *player);
+void broadcast_post(BroadcastSender *sender, BroadcastBatch *batch);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define FLIGHT_RECORDER_EVENTS 65536 // Power of two, the oldest events are overwritten
+#define FLIGHT_RECORDER_MASK (FLIGHT_RECORDER_EVENTS - 1)
+#define NO_CONNECTION 0              // Connection id of the events that belong to the round, not to a client
+
+typedef enum {
+    FLIGHT_ACCEPT,
+    FLIGHT_MESSAGE_RECEIVED,  // detail: message type
+    FLIGHT_VALIDATION_DONE,   // detail: points, -1 for a rejected word
+    FLIGHT_RESPONSE_WRITTEN,  // detail: message type of the request
+    FLIGHT_DISCONNECT,
+    FLIGHT_TRANSITION_START,  // detail: round iteration for all the round events
+    FLIGHT_ROUND_PUBLISHED,
+    FLIGHT_READERS_DRAINED,
+    FLIGHT_SCOREBOARD_ENCODED,
+    FLIGHT_SCOREBOARD_SENT,
+    FLIGHT_TRANSITION_END
+} FlightEventType;
+
+// A slot is valid when sequence is the index it was written for plus one, 0 while it's being written
+typedef struct {
+    atomic_ulong sequence;
+    long long timestamp_ns;
+    int connection_id;
+    FlightEventType type;
+    long detail;
+} FlightEvent;
+
+void flight_recorder_init(const char *dump_path);
+void flight_record(FlightEventType type, int connection_id, long detail);
+void flight_recorder_dump(int fd);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "macros.h"
+#include "player_handler.h"
+
+#define DEFAULT_LEADERBOARD_TOP_K 5
+#define DEFAULT_LEADERBOARD_PUSH_MS 1000
+
+typedef struct {
+    Player* player;
+    int score;
+    unsigned long stamp;     // Equal scores are ranked by who reached them first
+    unsigned int priority;   // Random, the tree is a heap on it so it stays balanced
+    int left, right, parent; // Slots of the linked entries, -1 for none
+    int count;               // Entries in the subtree, which gives ranks in O(log n)
+} LeaderboardEntry;
+
+// Players ordered by score while the round goes on, as a treap counting its subtrees.
+// Each player knows its own slot, so a score change, a removal or a rank lookup is O(log n).
+typedef struct {
+    LeaderboardEntry* entries; // Slots, a player keeps its slot until it leaves
+    int size;                  // Players in the board
+    int slots;                 // Slots ever used
+    int capacity;
+    int root;
+    int free_slot;             // First slot left by a player, chained through parent
+    unsigned long next_stamp;
+    unsigned int seed;
+    int top_k;
+    unsigned long top_version; // Bumped every time the top K changes
+    pthread_mutex_t mutex;
+} Leaderboard;
+
+Leaderboard* create_leaderboard(int top_k);
+void leaderboard_add(Leaderboard* board, Player* player);
+void leaderboard_remove(Leaderboard* board, Player* player);
+void leaderboard_update(Leaderboard* board, Player* player, int score);
+void leaderboard_reset(Leaderboard* board);
+int leaderboard_first(Leaderboard* board);
+int leaderboard_next(Leaderboard* board, int slot);
+
+#endif
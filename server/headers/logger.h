@@ -0,0 +1,60 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR
+} LogLevel;
+
+// Levels below this are compiled out, e.g. -DLOG_MIN_LEVEL=LOG_LEVEL_INFO for a build without debug output
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define DEFAULT_LOG_LEVEL LOG_LEVEL_INFO
+#define LOG_MESSAGE_SIZE 240   // Longer messages are truncated
+#define LOG_RING_SLOTS 256     // Records per thread, a full ring drops new records
+#define LOG_FLUSH_MS 10        // Longest time a record waits before being written
+
+// One formatted record, written by its thread and read by the writer thread
+typedef struct {
+    long long timestamp_ns;
+    LogLevel level;
+    int length;
+    char text[LOG_MESSAGE_SIZE];
+} LogRecord;
+
+// Single-producer single-consumer ring owned by one thread at a time.
+// Rings of exited threads are drained and then handed to new threads.
+typedef struct LogRing {
+    LogRecord records[LOG_RING_SLOTS];
+    atomic_uint head;          // Next slot to fill, written by the owner
+    atomic_uint tail;          // Next slot to write out, written by the writer thread
+    atomic_bool in_use;
+    struct LogRing *next;
+} LogRing;
+
+extern atomic_int log_level;
+
+void log_init(LogLevel level, int fd);
+void log_write(LogLevel level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void log_flush();
+long log_dropped();
+bool parse_log_level(const char *name, LogLevel *level);
+
+// Arguments are not evaluated when the level is disabled
+#define log_enabled(level) ((level) >= LOG_MIN_LEVEL && (level) >= atomic_load_explicit(&log_level, memory_order_relaxed))
+#define LOG_AT(level, ...) do { if (log_enabled(level)) log_write(level, __VA_ARGS__); } while (0)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
@@ -16,13 +16,16 @@
 #define PORT_ERROR (Error){1, "Port already in use or invalid"}
 #define SERVER_NAME_ERROR (Error){2, "Invalid server name"}
 #define NEGATIVE_PARAM_ERROR (Error){3, "Negative parameter passed - check your input"}
-#define WRONG_PARAMS_ERROR (Error){4, "Wrong parameters passed\nUsage: ./paroliere_srv server_name server_port [--matrici matrix_file] [--durata game_duration] [--seed randomization_seed] [--diz dictionary_file]"}
+#define WRONG_PARAMS_ERROR (Error){4, "Wrong parameters passed\nUsage: ./paroliere_srv server_name server_port [--matrici matrix_file] [--durata game_duration] [--seed randomization_seed] [--diz dictionary_file] [--sim rounds [--sim-players n] [--sim-words n]]"}
 #define CONFIG_ERROR_BACKLOG (Error){5, "Configuration file - socket_backlog not found or invalid"}
 #define FILE_OPEN_ERROR (Error){6, "Error opening file"}
 #define FILE_SIZE_ERROR (Error){7, "Error: Insufficient data in file"}
 #define MEMORY_ALLOCATION_ERROR (Error){8, "Error: Memory allocation failed"}
 #define LOCK_MUTEX_ERROR (Error){9, "Error: Mutex lock failed"}
 #define MAX_PLAYERS_ERROR (Error){10, "Error: Maximum number of players reached"}
+#define ALREADY_REGISTERED_ERROR (Error){11, "Player already registered"}
+#define USERNAME_TAKEN_ERROR (Error){12, "Invalid username"}
+#define CONFIG_ERROR_VALUE (Error){13, "Configuration file - invalid value"}
 
 typedef struct {
     int code;
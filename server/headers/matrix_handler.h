@@ -11,7 +11,6 @@
 #include "macros.h"
 #include "player_handler.h"
 #include "utils.h"
-#include "server.h"
 
 #define MATRIX_SIZE 4
 #define MATRIX_BYTES (MATRIX_SIZE * MATRIX_SIZE * sizeof(Cell))
@@ -43,7 +42,6 @@ typedef struct TrieNode{
 // Function prototypes
 void init_matrix_from_file(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char* fileName, int iteration);
 void init_matrix_random(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
-void send_matrix_to_all(PlayerArray *players_array, Cell matrix[MATRIX_SIZE][MATRIX_SIZE]);
 bool is_word_in_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], char* word);
 bool is_word_in_dictionary(TrieNode* dictionary_root, char* word);
 bool form_word(const char* word, int index, int prev_row, int prev_col, LetterPositions* letter_hash, bool used[MATRIX_SIZE][MATRIX_SIZE]);
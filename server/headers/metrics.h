@@ -0,0 +1,56 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define MAX_METRICS 64
+#define HISTOGRAM_SUB_BUCKETS 16  // Per power of two, every bucket is at most 1/16 wide (HDR style)
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+} MetricKind;
+
+// Log-linear latency histogram in nanoseconds, recording is a few relaxed atomic adds
+typedef struct {
+    atomic_long buckets[HISTOGRAM_BUCKETS];
+    atomic_long count;
+    atomic_long sum_ns;
+} Histogram;
+
+// Metrics are registered at startup and never removed, series of one family are registered one after another
+typedef struct {
+    const char *name;
+    const char *labels;     // e.g. type="parola", NULL for none
+    const char *help;
+    MetricKind kind;
+    atomic_long value;      // Counters and gauges
+    long (*read)(void);     // Counters and gauges computed when scraped, NULL otherwise
+    Histogram *histogram;
+} Metric;
+
+Metric* metrics_counter(const char *name, const char *labels, const char *help);
+Metric* metrics_read_counter(const char *name, const char *labels, const char *help, long (*read)(void));
+Metric* metrics_gauge(const char *name, const char *labels, const char *help, long (*read)(void));
+Metric* metrics_histogram(const char *name, const char *labels, const char *help);
+
+void histogram_record(Metric *metric, long long value_ns);
+long long histogram_quantile(Metric *metric, double quantile);
+size_t metrics_render(char **buffer);
+void start_admin_server(const char *socket_path);
+
+static inline void metric_add(Metric *metric, long delta) {
+    atomic_fetch_add_explicit(&metric->value, delta, memory_order_relaxed);
+}
+
+static inline void metric_set(Metric *metric, long value) {
+    atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+}
+
+#endif
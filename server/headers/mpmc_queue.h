@@ -0,0 +1,31 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE_SIZE 64
+
+// Bounded lock-free queue of pointers for many producers and many consumers (Vyukov's design):
+// every slot carries a sequence number telling whether it's free for the producer or full for the consumer
+// of a given lap, so push and pop are one CAS on their position plus one store on the slot.
+typedef struct {
+    atomic_size_t sequence;
+    void *item;
+} MpmcSlot;
+
+typedef struct {
+    MpmcSlot *slots;
+    size_t mask;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_position;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_position;
+} MpmcQueue;
+
+MpmcQueue* mpmc_create(size_t capacity);
+bool mpmc_push(MpmcQueue *queue, void *item);
+bool mpmc_pop(MpmcQueue *queue, void **item);
+size_t mpmc_size(MpmcQueue *queue);
+
+#endif
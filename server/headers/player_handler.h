@@ -6,23 +6,33 @@
 #include <string.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 #include "macros.h"
+#include "arena.h"
 
 #define MAX_USERNAME_LENGTH 10
-#define MAX_PLAYERS 32
+#define MAX_PLAYERS 32 // Default, can be changed with max_players in config.txt
 #define INITIAL_PLAYER_CAPACITY 5
 #define INITIAL_WORD_CAPACITY 10
+#define PLAYER_OUTPUT_SIZE 1024 // One whole reply frame
 
+// One per connection, allocated when the client connects and freed with its last reference.
+// The registry only stores pointers, so a Player never moves while other threads use it.
 typedef struct {
     char username[MAX_USERNAME_LENGTH];
-    int score;
-    char** words;
+    atomic_int score;
+    atomic_bool is_registered;
+    char** words;           // Room thread only, lives in the round arena
     int word_size;
     int word_capacity;
     int fd;
-    pthread_t scorer_tid;
-    pthread_t tid;
+    int connection_id;        // Unique for the whole run, unlike fd
+    int leaderboard_slot;     // Guarded by the leaderboard mutex
+    int last_pushed_rank;     // Guarded by the leaderboard mutex
+    atomic_int references;    // The connection thread's, plus one per broadcast writing to the player
+    pthread_mutex_t send_lock; // Held while a frame is written to fd, so replies and broadcasts never interleave
+    char output[PLAYER_OUTPUT_SIZE]; // Replies are encoded here, only by the connection's own thread
 } Player;
 
 
@@ -37,24 +47,34 @@ typedef struct {
 } ScoresList;
 
 
+// Registered players, read-mostly: lookups and broadcasts share the read lock,
+// only registration and disconnection take the write lock.
 typedef struct {
-    Player* players;
+    Player** players;
     int size;
     int capacity;
+    int max_size;
+    pthread_rwlock_t lock;
 } PlayerArray;
 
 
-ScoresList* create_player_score_list(int length);
-void free_player_score_list(ScoresList* list);
+ScoresList* create_player_score_list(Arena* arena, int length);
+ScoresList* snapshot_player_scores(PlayerArray* registry, Arena* arena);
 int sort_helper_players(const void* a, const void* b);
-void remove_player(PlayerArray* registry, int fd);
+Player* create_player(int fd);
+void destroy_player(Player* player);
+void retain_player(Player* player);
+void release_player(Player* player);
+Error add_player(PlayerArray* registry, Player* player, const char* username);
+void remove_player(PlayerArray* registry, Player* player);
 bool is_username_taken(PlayerArray* registry, const char* username);
-bool has_player_used_word(Player* player, char* word);
+bool has_player_used_word(Player* player, const char* word);
+bool add_word_if_new(Arena* arena, Player* player, const char* word);
 void update_player_score(Player* player, int points_gained);
-void add_word_to_player(Player* player, const char* word);
-Player* add_player(PlayerArray* registry, int fd, pthread_t tid, const char* username);
+void add_word_to_player(Arena* arena, Player* player, const char* word);
+void reset_player_round(Player* player);
 Player* find_player(PlayerArray* registry, int fd);
-PlayerScore* add_player_score(ScoresList* score_list, char* username, int score);
-PlayerArray* create_player_registry();
+PlayerScore* add_player_score(ScoresList* score_list, const char* username, int score);
+PlayerArray* create_player_registry(int max_size);
 
 #endif
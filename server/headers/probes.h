@@ -0,0 +1,36 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+// USDT probes of the "paroliere" provider, listed with: readelf -n executables/paroliere_srv
+// A probe is a single nop until a tracer (bpftrace, perf, systemtap) attaches to it.
+// They need <sys/sdt.h> (systemtap-sdt-dev / systemtap-sdt-devel) at build time;
+// without it, or with -DPAROLIERE_NO_USDT, they compile to nothing.
+//
+// message__receive(connection_id, type, size)      handle_player, after a message is parsed
+// message__dispatched(connection_id, type)         handle_player, after its reply was written
+// word__start(connection_id, word)                 handle_word_submission entry
+// word__end(connection_id, points)                 handle_word_submission exit, points -1 if rejected
+// dictionary__load__start(filename)
+// dictionary__load__end(word_count)
+// round__transition__start(iteration, next_state)  next_state: GameState entered, 0 waiting, 1 game
+// round__transition__end(iteration, next_state)
+
+#if !defined(PAROLIERE_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PAROLIERE_USDT 1
+#endif
+#endif
+
+#ifdef PAROLIERE_USDT
+#define PROBE1(name, a) DTRACE_PROBE1(paroliere, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(paroliere, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(paroliere, name, a, b, c)
+#else
+// Arguments are still referenced so variables kept only for probes don't warn, the compiler drops them
+#define PROBE1(name, a) do { (void)(a); } while (0)
+#define PROBE2(name, a, b) do { (void)(a); (void)(b); } while (0)
+#define PROBE3(name, a, b, c) do { (void)(a); (void)(b); (void)(c); } while (0)
+#endif
+
+#endif
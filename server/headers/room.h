@@ -0,0 +1,49 @@
+#ifndef ROOM_H
+#define ROOM_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "mpmc_queue.h"
+
+#define ROOM_QUEUE_SLOTS 1024 // Events per producer thread, a producer waits while its queue is full
+
+typedef struct {
+    int type;
+    void *data; // Owned by the sender, which usually waits on it until the room is done with it
+} RoomEvent;
+
+// Single-producer single-consumer queue from one thread to the room thread.
+// Queues of exited threads are handed to new threads once the room has emptied them.
+typedef struct RoomQueue {
+    RoomEvent events[ROOM_QUEUE_SLOTS];
+    _Alignas(CACHE_LINE_SIZE) atomic_uint head; // Next slot to fill, written by the producer
+    _Alignas(CACHE_LINE_SIZE) atomic_uint tail; // Next event to handle, written by the room thread
+    atomic_bool in_use;
+    atomic_bool producer_waiting;                // The producer sleeps on space until the room frees a slot
+    sem_t space;
+    struct Room *room;
+    struct RoomQueue *next;                      // In the room's list, never unlinked
+    struct RoomQueue *thread_next;               // In the producer thread's list
+} RoomQueue;
+
+// A room is an actor: the state it owns is only touched by its thread, which handles the events
+// posted by the other threads one at a time and runs a tick whenever a deadline is reached.
+typedef struct Room {
+    void (*handle_event)(RoomEvent *event);
+    long long (*next_tick_ms)(void);    // Monotonic time of the next tick, -1 when only events wake the room
+    void (*tick)(void);
+    _Atomic(RoomQueue*) queues;
+    pthread_mutex_t queues_mutex;       // Only taken the first time a thread posts to the room
+    atomic_bool sleeping;
+    sem_t wakeup;
+    atomic_long events_processed;
+} Room;
+
+Room* room_create(void (*handle_event)(RoomEvent *event), long long (*next_tick_ms)(void), void (*tick)(void));
+void room_post(Room *room, int type, void *data);
+
+#endif
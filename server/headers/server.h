@@ -9,19 +9,39 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <signal.h>
 #include <pthread.h>
 #include <arpa/inet.h>
+#include <sched.h>
+#include <time.h>
+#include <stdatomic.h>
 
 
 #include "macros.h"
+#include "matrix_handler.h"
+#include "player_handler.h"
+#include "leaderboard.h"
+#include "logger.h"
+#include "metrics.h"
+#include "flight_recorder.h"
+#include "simulation.h"
 
 #define PRE_GAME_DURATION 10 // seconds
 #define GAME_DURATION 60 // seconds
+#define WAITING_DURATION 20 // seconds, default of --attesa
 
-#define MAX_CSV_LENGTH 1024
 #define MAX_BUFFER_SIZE 1024
 #define MAX_MESSAGE_DATA_SIZE 1024
+// Length prefix, type and payload size in front of every frame
+#define FRAME_HEADER_SIZE (sizeof(int) + sizeof(char) + sizeof(int))
+#define MAX_FRAME_DATA_SIZE (MAX_BUFFER_SIZE - FRAME_HEADER_SIZE)
+#define MAX_SCORE_DIGITS 11
+// Live standings: "rank,total" then ",username,score" per listed player, always in one frame
+#define LEADERBOARD_PREFIX_LENGTH (2 * MAX_SCORE_DIGITS + 1)
+#define LEADERBOARD_ENTRY_LENGTH (MAX_USERNAME_LENGTH + MAX_SCORE_DIGITS + 1)
+#define MAX_LEADERBOARD_TOP_K ((int)(MAX_FRAME_DATA_SIZE - LEADERBOARD_PREFIX_LENGTH) / LEADERBOARD_ENTRY_LENGTH)
+#define MAX_SOCKET_PATH_LENGTH 108
 
 #define MSG_OK 'K'
 #define MSG_ERR 'E'
@@ -31,12 +51,22 @@
 #define MSG_TEMPO_ATTESA 'A'
 #define MSG_PAROLA 'W'
 #define MSG_PUNTI_FINALI 'F'
+#define MSG_PUNTI_FINALI_PARZIALI 'f' // A chunk of the final scoreboard, more frames follow
 #define MSG_PUNTI_PAROLA 'P'
+#define MSG_CLASSIFICA 'L' // Live standings: rank,total,username,score,...
 
 typedef struct {
     // char server_ip[16];
     int port;
     int backlog;
+    int max_players;
+    int leaderboard_top_k;
+    int leaderboard_push_ms;
+    int validation_workers;
+    int dictionary_cache_entries;   // Dictionary verdicts kept across rounds, rounded up to a power of two
+    LogLevel log_level;
+    char admin_socket[MAX_SOCKET_PATH_LENGTH]; // Unix socket serving the metrics, /tmp/paroliere_srv_<port>.sock by default
+    char flight_recorder_file[MAX_SOCKET_PATH_LENGTH]; // Dump of the flight recorder, /tmp/paroliere_srv_<port>.flight by default
 } Config;
 
 typedef struct {
@@ -50,11 +80,33 @@ typedef enum {
     GAME_STATE
 } GameState;
 
-void init_server(char *server_name, int server_port, unsigned int randomization_seed, int game_length, char *matrix_file, char *dictionary_file);
-void send_matrix_to_client(int client_fd);
-void send_message_to_client(const Message *msg, int client_fd);
-static void transition_to_game_state();
-static void free_scores_list();
-static void transition_to_waiting_state();
+// Final scoreboard as a sequence of complete frames, ready to be written to a socket
+typedef struct {
+    char* data;
+    size_t size;
+    int frames;
+    int players;
+} EncodedScoreboard;
+
+// Read-mostly view of the current round, never modified while it's published
+typedef struct {
+    GameState state;
+    int iteration;
+    long long deadline_ms; // Monotonic time at which the current phase ends
+    Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
+    atomic_int readers;
+} RoundSnapshot;
+
+void init_server(char *server_name, int server_port, unsigned int randomization_seed, int game_length, int waiting_length, char *matrix_file, char *dictionary_file, const SimulationOptions *simulation);
+void send_matrix_to_client(Player *player);
+int serialize_message(const Message *msg, char *buffer, size_t buffer_size);
+int deserialize_message(const char *buffer, size_t buffer_size, Message *msg);
+RoundSnapshot* acquire_round();
+void release_round(RoundSnapshot* round);
+GameState get_game_state();
+unsigned int get_time_left();
+void handle_registration(Player *player, char *username);
+void handle_word_submission(Player *player, char *word);
+void advance_round();
 
 #endif
@@ -0,0 +1,23 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "matrix_handler.h"
+
+#define DEFAULT_SIM_PLAYERS 16
+#define DEFAULT_SIM_WORDS 20 // Per player and per round
+
+// Accelerated run: no sockets, the rounds follow a virtual clock and scripted players submit words in-process
+typedef struct {
+    int rounds;           // 0 runs the regular server
+    int players;
+    int words_per_player;
+    unsigned int seed;    // The --seed of the run, the matrices and the scripted words depend only on it
+} SimulationOptions;
+
+bool run_simulation(const SimulationOptions *options, TrieNode *dictionary_root);
+
+#endif
@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h> // For _exit
+#include <time.h>
+#include <stdbool.h>
 
 #define BOLD "\033[1m"
 #define RESET "\033[0m"
@@ -35,5 +37,10 @@ void handle_error(Error err);
 int parse_positive_int(const char *str);
 float parse_position_float(const char *str);
 char get_random_letter();
+long get_rss_kb();
+long long monotonic_ms();
+long long monotonic_ns();
+bool write_all(int fd, const char *buffer, size_t size);
+void sleep_until_ms(long long deadline_ms);
 
 #endif
\ No newline at end of file
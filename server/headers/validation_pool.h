@@ -0,0 +1,46 @@
+#ifndef VALIDATION_POOL_H
+#define VALIDATION_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+#include "player_handler.h"
+#include "mpmc_queue.h"
+
+#define DEFAULT_VALIDATION_WORKERS 4
+
+// A word handed by a connection thread to the pool, it lives on that thread's stack until done is posted
+typedef struct {
+    Player *player;
+    char *word;              // View into the connection buffer, the connection thread waits so it stays valid
+    char reply_type;         // Set by the worker, the payload is already encoded in player->output
+    int reply_size;
+    long points;             // -1 for a rejected word
+    long allocations;        // Heap allocations made for this job off the connection thread
+    int iteration;           // Round the word was validated against
+    long long enqueued_ns;
+    long long started_ns;
+    sem_t done;
+} ValidationJob;
+
+// Fixed set of workers validating words, connection threads only read sockets and write replies.
+// validate returns false to hand the job on to forward, which must then call validation_job_done.
+typedef struct {
+    MpmcQueue *queue;
+    sem_t pending;                // One post per queued job, idle workers sleep on it
+    atomic_int busy_workers;
+    atomic_int replies_pending;   // Validated, waiting for their connection thread to write them
+    int workers;
+    bool (*validate)(ValidationJob *job);
+    void (*forward)(ValidationJob *job);
+} ValidationPool;
+
+ValidationPool* create_validation_pool(int workers, size_t capacity, bool (*validate)(ValidationJob *job), void (*forward)(ValidationJob *job));
+void validation_pool_run(ValidationPool *pool, ValidationJob *job);
+void validation_job_done(ValidationPool *pool, ValidationJob *job);
+void validation_reply_sent(ValidationPool *pool);
+
+#endif
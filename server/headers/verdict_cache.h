@@ -0,0 +1,38 @@
+#ifndef VERDICT_CACHE_H
+#define VERDICT_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "mpmc_queue.h"
+#include "matrix_handler.h"
+
+#define DEFAULT_DICTIONARY_CACHE_ENTRIES 65536
+#define VERDICT_CACHE_WAYS 2        // Slots a word can be in, a set is one cache line
+#define VERDICT_CACHE_KEY_WORDS 2   // A word of up to MAX_WORD_LENGTH letters, zero padded
+
+// One cached dictionary verdict. The sequence is odd while a writer fills the slot and 0 while it's empty,
+// a reader keeps what it read only if the sequence was even and unchanged around it (a seqlock).
+typedef struct {
+    atomic_ulong sequence;
+    atomic_bool in_dictionary;
+    _Atomic unsigned long long key[VERDICT_CACHE_KEY_WORDS];
+} VerdictSlot;
+
+// Bounded, set-associative cache of is_word_in_dictionary's answers, shared by the validation workers.
+// Lookups never block and never write, an insert that finds its slot being written gives up.
+// The dictionary never changes while the server runs, so entries are only ever replaced by newer words.
+typedef struct {
+    VerdictSlot *slots;
+    size_t set_mask;
+    atomic_long entries;    // Slots holding a word
+    atomic_long evictions;  // Words replaced by another word
+} VerdictCache;
+
+VerdictCache* verdict_cache_create(size_t capacity);
+bool verdict_cache_lookup(VerdictCache *cache, const char *word, bool *in_dictionary);
+void verdict_cache_insert(VerdictCache *cache, const char *word, bool in_dictionary);
+
+#endif
@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <errno.h>
+
+#include "allocation_counter.h"
+
+static __thread long allocations = 0; // Initial-exec TLS, safe to touch from inside malloc
+
+long thread_allocations() {
+    return allocations;
+}
+
+// Charging to this thread the allocations another thread made on its behalf
+void thread_allocations_add(long count) {
+    allocations += count;
+}
+
+#if ALLOCATION_COUNTING
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+
+// free stays glibc's, every block still comes from its allocator
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+// The aligned entry points don't go through malloc in glibc, they're counted here on their own
+void *aligned_alloc(size_t alignment, size_t size) {
+    allocations++;
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0) {
+        return EINVAL;
+    }
+    allocations++;
+    void *block = __libc_memalign(alignment, size);
+    if (!block) {
+        return ENOMEM;
+    }
+    *ptr = block;
+    return 0;
+}
+
+// The obsolete ones too, some libraries still call them
+void *memalign(size_t alignment, size_t size) {
+    allocations++;
+    return __libc_memalign(alignment, size);
+}
+
+void *valloc(size_t size) {
+    allocations++;
+    return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size) {
+    allocations++;
+    return __libc_pvalloc(size);
+}
+#endif
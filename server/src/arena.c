@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "macros.h"
+#include "utils.h"
+
+// Rounding a size up so that every allocation starts on an aligned address
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+}
+
+static ArenaChunk* create_chunk(size_t capacity) {
+    ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + capacity);
+    if (!chunk) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+Arena* arena_create(size_t chunk_size) {
+    Arena *arena = malloc(sizeof(Arena));
+    if (!arena) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    arena->chunk_size = chunk_size;
+    arena->first = create_chunk(chunk_size);
+    arena->current = arena->first;
+    atomic_init(&arena->bytes_used, 0);
+    atomic_init(&arena->bytes_reserved, chunk_size);
+    return arena;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = align_up(size);
+
+    // Looking for the first chunk (from the current one on) with enough room.
+    // Chunks after current are the ones kept from previous rounds, so they are empty.
+    ArenaChunk *chunk = arena->current;
+    while (chunk->capacity - chunk->used < size && chunk->next) {
+        chunk = chunk->next;
+    }
+
+    if (chunk->capacity - chunk->used < size) {
+        size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+        chunk->next = create_chunk(capacity);
+        chunk = chunk->next;
+        atomic_fetch_add_explicit(&arena->bytes_reserved, capacity, memory_order_relaxed);
+    }
+
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->current = chunk;
+    atomic_fetch_add_explicit(&arena->bytes_used, size, memory_order_relaxed);
+    return ptr;
+}
+
+char* arena_strdup(Arena* arena, const char* str) {
+    size_t len = strlen(str) + 1;
+    char *copy = arena_alloc(arena, len);
+    memcpy(copy, str, len);
+    return copy;
+}
+
+// Releasing every allocation at once, chunks are kept to be reused by the next round
+void arena_reset(Arena* arena) {
+    for (ArenaChunk *chunk = arena->first; chunk; chunk = chunk->next) {
+        chunk->used = 0;
+    }
+    arena->current = arena->first;
+    atomic_store_explicit(&arena->bytes_used, 0, memory_order_relaxed);
+}
+
+void arena_destroy(Arena* arena) {
+    ArenaChunk *chunk = arena->first;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+// Both counts can be read from any thread, e.g. by the metrics
+size_t arena_bytes_used(Arena* arena) {
+    return atomic_load_explicit(&arena->bytes_used, memory_order_relaxed);
+}
+
+size_t arena_bytes_reserved(Arena* arena) {
+    return atomic_load_explicit(&arena->bytes_reserved, memory_order_relaxed);
+}
@@ -44,7 +44,7 @@ void check_args(int argc, char **server_name, int *server_port) {
     handle_error(err_port);
 }
 
-void handle_args(int argc, char *argv[], char **server_name, int *server_port, unsigned int *randomization_seed, float *game_length, char **matrix_file, char **dictionary_file) {
+void handle_args(int argc, char *argv[], char **server_name, int *server_port, unsigned int *randomization_seed, float *game_length, int *waiting_length, char **matrix_file, char **dictionary_file, SimulationOptions *simulation) {
     *server_name = argv[1];
     *server_port = atoi(argv[2]);
     check_args(argc, server_name, server_port);
@@ -52,9 +52,13 @@ void handle_args(int argc, char *argv[], char **server_name, int *server_port, u
     // Set default values
     *randomization_seed = (unsigned int)time(NULL);
     *game_length = GAME_DURATION;
+    *waiting_length = WAITING_DURATION;
     printf("new game length: %.f\n", *game_length);
     *matrix_file = NULL;
     *dictionary_file = NULL;
+    simulation->rounds = 0;
+    simulation->players = DEFAULT_SIM_PLAYERS;
+    simulation->words_per_player = DEFAULT_SIM_WORDS;
 
     int option;
     // Defining long options for getopt_long
@@ -63,13 +67,17 @@ void handle_args(int argc, char *argv[], char **server_name, int *server_port, u
     static struct option long_opts[] = {
         {"matrici", required_argument, NULL, 'm'},
         {"durata",  required_argument, NULL, 'd'},
+        {"attesa",  required_argument, NULL, 'a'},
         {"seed",    required_argument, NULL, 's'},
         {"diz",     required_argument, NULL, 'z'},
+        {"sim",         required_argument, NULL, 'S'},
+        {"sim-players", required_argument, NULL, 'P'},
+        {"sim-words",   required_argument, NULL, 'W'},
         {0, 0, 0, 0}  // Terminating element
     };
 
     // Process command line options
-    while ((option = getopt_long(argc, argv, "m:d:s:z:", long_opts, NULL)) != -1) {
+    while ((option = getopt_long(argc, argv, "m:d:a:s:z:S:P:W:", long_opts, NULL)) != -1) {
         switch (option) {
             case 'm':
                 *matrix_file = optarg;
@@ -77,14 +85,29 @@ void handle_args(int argc, char *argv[], char **server_name, int *server_port, u
             case 'd':
                 *game_length = parse_position_float(optarg) * 60; // convert minutes to seconds
                 break;
+            case 'a':
+                *waiting_length = parse_positive_int(optarg); // seconds between two games
+                break;
             case 's':
                 *randomization_seed = (unsigned int)parse_positive_int(optarg);
                 break;
             case 'z':
                 *dictionary_file = optarg;
                 break;
+            case 'S':
+                simulation->rounds = parse_positive_int(optarg);
+                break;
+            case 'P':
+                simulation->players = parse_positive_int(optarg);
+                break;
+            case 'W':
+                simulation->words_per_player = parse_positive_int(optarg);
+                break;
             default:
                 handle_error(WRONG_PARAMS_ERROR);
         }
     }
+
+    // The simulation replays the same rounds for the same seed
+    simulation->seed = *randomization_seed;
 }
\ No newline at end of file
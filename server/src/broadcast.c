@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "broadcast.h"
+#include "macros.h"
+#include "utils.h"
+#include "logger.h"
+
+// Called while the player can't be released, under the registry or leaderboard lock. It's kept alive until the broadcast is sent
+void broadcast_add(Broadcast *broadcast, Player *player, const char *data, size_t size) {
+    if (broadcast->size == broadcast->capacity) {
+        int capacity = broadcast->capacity ? broadcast->capacity * 2 : 64;
+        BroadcastTarget *targets = realloc(broadcast->targets, capacity * sizeof(BroadcastTarget));
+        struct pollfd *pollfds = realloc(broadcast->pollfds, capacity * sizeof(struct pollfd));
+        if (!targets || !pollfds) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+        broadcast->targets = targets;
+        broadcast->pollfds = pollfds;
+        broadcast->capacity = capacity;
+    }
+
+    retain_player(player);
+    broadcast->targets[broadcast->size++] = (BroadcastTarget){ .player = player, .data = data, .size = size };
+}
+
+// Writing what the socket takes right now, false once the connection is gone
+static bool write_available(BroadcastTarget *target) {
+    while (target->sent < target->size) {
+        const char *data = target->data + target->sent;
+        size_t size = target->size - target->sent;
+        ssize_t written = send(target->player->fd, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (written < 0 && errno == ENOTSOCK) {
+            written = write(target->player->fd, data, size); // The simulation's players write to /dev/null
+        }
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        target->sent += written;
+    }
+    return true;
+}
+
+static void finish(BroadcastTarget *target) {
+    if (target->locked) {
+        pthread_mutex_unlock(&target->player->send_lock);
+        target->locked = false;
+    }
+    target->done = true;
+}
+
+// Writing every target's frames, returns how many players were too slow and got disconnected.
+// A send lock held by the player's own thread is retried, never waited for.
+int broadcast_send(Broadcast *broadcast) {
+    long long deadline_ms = monotonic_ms() + BROADCAST_TIMEOUT_MS;
+    int remaining = broadcast->size;
+
+    while (remaining > 0) {
+        int polled = 0;
+        bool lock_busy = false;
+        for (int i = 0; i < broadcast->size; i++) {
+            BroadcastTarget *target = &broadcast->targets[i];
+            if (target->done) continue;
+            if (!target->locked) {
+                if (pthread_mutex_trylock(&target->player->send_lock) != 0) {
+                    lock_busy = true;
+                    continue;
+                }
+                target->locked = true;
+            }
+
+            bool connected = write_available(target);
+            if (!connected || target->sent == target->size) {
+                finish(target);
+                remaining--;
+            } else {
+                broadcast->pollfds[polled++] = (struct pollfd){ .fd = target->player->fd, .events = POLLOUT };
+            }
+        }
+
+        long long left_ms = deadline_ms - monotonic_ms();
+        if (remaining == 0 || left_ms <= 0) break;
+        poll(broadcast->pollfds, polled, lock_busy && left_ms > 1 ? 1 : left_ms);
+    }
+
+    // The players left behind stopped reading: their connection is shut down and their thread leaves as on a disconnect.
+    int slow = 0;
+    for (int i = 0; i < broadcast->size; i++) {
+        BroadcastTarget *target = &broadcast->targets[i];
+        if (!target->done) {
+            LOG_WARN("Client %d took %zu of %zu broadcast bytes in %d ms, disconnecting it",
+                     target->player->fd, target->sent, target->size, BROADCAST_TIMEOUT_MS);
+            shutdown(target->player->fd, SHUT_RDWR);
+            finish(target);
+            slow++;
+        }
+        release_player(target->player);
+    }
+    broadcast->size = 0;
+    return slow;
+}
+
+// Sending the posted batches one after another, a slow client delays this thread only
+static void* broadcast_sender_loop(void *arg) {
+    BroadcastSender *sender = (BroadcastSender *)arg;
+    while (1) {
+        while (sem_wait(&sender->ready) == -1 && errno == EINTR);
+        void *item;
+        mpmc_pop(sender->pending, &item); // Pushed whole by the single poster before its post
+        BroadcastBatch *batch = (BroadcastBatch *)item;
+
+        metric_add(sender->slow_clients, broadcast_send(&batch->broadcast));
+        mpmc_push(sender->spare, batch);
+        sem_post(&sender->spares);
+    }
+    return NULL;
+}
+
+BroadcastSender* create_broadcast_sender(Metric *slow_clients) {
+    BroadcastSender *sender = malloc(sizeof(BroadcastSender));
+    if (!sender) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    // Both queues can hold every batch, so a push never fails
+    sender->pending = mpmc_create(BROADCAST_BATCHES);
+    sender->spare = mpmc_create(BROADCAST_BATCHES);
+    sem_init(&sender->ready, 0, 0);
+    sem_init(&sender->spares, 0, 0);
+    sender->batches = 0;
+    sender->slow_clients = slow_clients;
+
+    pthread_t sender_thread;
+    pthread_create(&sender_thread, NULL, broadcast_sender_loop, sender);
+    pthread_detach(sender_thread);
+    return sender;
+}
+
+// Getting a batch holding a copy of the frames: a sent one, a new one while fewer than BROADCAST_BATCHES exist,
+// or the next one the sender finishes when that many broadcasts are already waiting for it
+BroadcastBatch* broadcast_batch(BroadcastSender *sender, const char *frames, size_t size) {
+    BroadcastBatch *batch;
+    bool spare = sem_trywait(&sender->spares) == 0;
+    if (!spare && sender->batches == BROADCAST_BATCHES) {
+        while (sem_wait(&sender->spares) == -1 && errno == EINTR);
+        spare = true;
+    }
+    if (spare) {
+        void *item;
+        mpmc_pop(sender->spare, &item);
+        batch = (BroadcastBatch *)item;
+    } else {
+        batch = calloc(1, sizeof(BroadcastBatch));
+        if (!batch) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+        sender->batches++;
+    }
+
+    if (batch->capacity < size) {
+        batch->data = realloc(batch->data, size);
+        if (!batch->data) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+        batch->capacity = size;
+    }
+    memcpy(batch->data, frames, size);
+    batch->size = size;
+    return batch;
+}
+
+// Same rules as broadcast_add: the player is retained until the sender is done with it
+void broadcast_batch_add(BroadcastBatch *batch, Player *player) {
+    broadcast_add(&batch->broadcast, player, batch->data, batch->size);
+}
+
+void broadcast_post(BroadcastSender *sender, BroadcastBatch *batch) {
+    mpmc_push(sender->pending, batch);
+    sem_post(&sender->ready);
+}
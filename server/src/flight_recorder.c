@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "flight_recorder.h"
+#include "macros.h"
+#include "utils.h"
+
+#define DUMP_LINE_SIZE 128
+#define DUMP_PATH_SIZE 256
+
+static FlightEvent events[FLIGHT_RECORDER_EVENTS];
+static atomic_ulong next_event = 0;
+static char dump_path[DUMP_PATH_SIZE];
+
+static const char *event_names[] = {
+    "accept", "message_received", "validation_done", "response_written", "disconnect",
+    "transition_start", "round_published", "readers_drained", "scoreboard_encoded", "scoreboard_sent", "transition_end"
+};
+
+// Claiming the next slot with one atomic add, writers never wait for each other
+void flight_record(FlightEventType type, int connection_id, long detail) {
+    unsigned long index = atomic_fetch_add_explicit(&next_event, 1, memory_order_relaxed);
+    FlightEvent *event = &events[index & FLIGHT_RECORDER_MASK];
+
+    // Seqlock-style: the fields are relaxed atomics, so a dump racing with a writer is well defined
+    atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    __atomic_store_n(&event->timestamp_ns, monotonic_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&event->connection_id, connection_id, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->type, type, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->detail, detail, __ATOMIC_RELAXED);
+    atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+}
+
+// Formatting without stdio, the dump runs inside signal handlers
+static char* append_string(char *out, const char *text) {
+    while (*text) *out++ = *text++;
+    return out;
+}
+
+static char* append_number(char *out, long long value) {
+    char digits[24];
+    int count = 0;
+    unsigned long long magnitude = value < 0 ? -(unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) *out++ = '-';
+    while (count > 0) *out++ = digits[--count];
+    return out;
+}
+
+// Writing the recorded events oldest first: sequence, microseconds since the oldest one,
+// microseconds since the previous one, connection id, event and detail.
+// Slots overwritten or still being written while we read them are skipped.
+void flight_recorder_dump(int fd) {
+    unsigned long end = atomic_load_explicit(&next_event, memory_order_acquire);
+    unsigned long start = end > FLIGHT_RECORDER_EVENTS ? end - FLIGHT_RECORDER_EVENTS : 0;
+    long long first_ns = -1, previous_ns = 0;
+    char line[DUMP_LINE_SIZE];
+
+    static const char header[] = "# sequence t_us delta_us connection event detail\n";
+    write_all(fd, header, sizeof(header) - 1);
+    for (unsigned long index = start; index < end; index++) {
+        FlightEvent *slot = &events[index & FLIGHT_RECORDER_MASK];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != index + 1) continue;
+        FlightEvent event = {
+            .timestamp_ns = __atomic_load_n(&slot->timestamp_ns, __ATOMIC_RELAXED),
+            .connection_id = __atomic_load_n(&slot->connection_id, __ATOMIC_RELAXED),
+            .type = __atomic_load_n(&slot->type, __ATOMIC_RELAXED),
+            .detail = __atomic_load_n(&slot->detail, __ATOMIC_RELAXED)
+        };
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != index + 1) continue;
+
+        if (first_ns < 0) first_ns = previous_ns = event.timestamp_ns;
+        char *out = line;
+        out = append_number(out, index);
+        out = append_string(out, " ");
+        out = append_number(out, (event.timestamp_ns - first_ns) / 1000);
+        out = append_string(out, " +");
+        out = append_number(out, (event.timestamp_ns - previous_ns) / 1000);
+        out = append_string(out, " ");
+        out = append_number(out, event.connection_id);
+        out = append_string(out, " ");
+        out = append_string(out, event.type <= FLIGHT_TRANSITION_END ? event_names[event.type] : "unknown");
+        out = append_string(out, " ");
+        out = append_number(out, event.detail);
+        out = append_string(out, "\n");
+        write_all(fd, line, out - line);
+        previous_ns = event.timestamp_ns;
+    }
+}
+
+static void dump_to_file() {
+    int fd = open(dump_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return;
+    flight_recorder_dump(fd);
+    close(fd);
+}
+
+static void handle_dump_signal(int signal_number) {
+    (void)signal_number;
+    dump_to_file();
+}
+
+// Dumping what led to the crash, then letting the default action terminate the process
+static void handle_crash_signal(int signal_number) {
+    dump_to_file();
+    raise(signal_number);
+}
+
+// SIGUSR1 dumps the events to dump_path at any time, a crash dumps them before the process dies
+void flight_recorder_init(const char *path) {
+    snprintf(dump_path, sizeof(dump_path), "%s", path);
+
+    struct sigaction dump_action = { .sa_handler = handle_dump_signal, .sa_flags = SA_RESTART };
+    sigemptyset(&dump_action.sa_mask);
+    sigaction(SIGUSR1, &dump_action, NULL);
+
+    struct sigaction crash_action = { .sa_handler = handle_crash_signal, .sa_flags = SA_RESETHAND };
+    sigemptyset(&crash_action.sa_mask);
+    int crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+    for (size_t i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); i++) {
+        sigaction(crash_signals[i], &crash_action, NULL);
+    }
+}
@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "leaderboard.h"
+#include "player_handler.h"
+#include "utils.h"
+#include "macros.h"
+
+Leaderboard* create_leaderboard(int top_k) {
+    Leaderboard* board = malloc(sizeof(Leaderboard));
+    if (!board) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    board->entries = malloc(INITIAL_PLAYER_CAPACITY * sizeof(LeaderboardEntry));
+    if (!board->entries) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    board->size = 0;
+    board->slots = 0;
+    board->capacity = INITIAL_PLAYER_CAPACITY;
+    board->root = -1;
+    board->free_slot = -1;
+    board->next_stamp = 0;
+    board->seed = 1;
+    board->top_k = top_k;
+    board->top_version = 0;
+    pthread_mutex_init(&board->mutex, NULL);
+    return board;
+}
+
+static bool ranks_before(const LeaderboardEntry* a, const LeaderboardEntry* b) {
+    return a->score > b->score || (a->score == b->score && a->stamp < b->stamp);
+}
+
+static int count_of(Leaderboard* board, int slot) {
+    return slot < 0 ? 0 : board->entries[slot].count;
+}
+
+// Recomputing the subtree count of a slot and pointing its children back at it
+static void pull_up(Leaderboard* board, int slot) {
+    LeaderboardEntry* entry = &board->entries[slot];
+    entry->count = 1 + count_of(board, entry->left) + count_of(board, entry->right);
+    if (entry->left >= 0) board->entries[entry->left].parent = slot;
+    if (entry->right >= 0) board->entries[entry->right].parent = slot;
+}
+
+// Splitting a subtree into the entries ranking before the given one and the others
+static void split(Leaderboard* board, int root, const LeaderboardEntry* key, int* before, int* after) {
+    if (root < 0) {
+        *before = *after = -1;
+        return;
+    }
+    LeaderboardEntry* entry = &board->entries[root];
+    if (ranks_before(entry, key)) {
+        split(board, entry->right, key, &entry->right, after);
+        *before = root;
+    } else {
+        split(board, entry->left, key, before, &entry->left);
+        *after = root;
+    }
+    pull_up(board, root);
+}
+
+// Joining two subtrees, every entry of before ranking before every entry of after
+static int merge(Leaderboard* board, int before, int after) {
+    if (before < 0) return after;
+    if (after < 0) return before;
+    if (board->entries[before].priority > board->entries[after].priority) {
+        board->entries[before].right = merge(board, board->entries[before].right, after);
+        pull_up(board, before);
+        return before;
+    }
+    board->entries[after].left = merge(board, before, board->entries[after].left);
+    pull_up(board, after);
+    return after;
+}
+
+static int insert(Leaderboard* board, int root, int slot) {
+    LeaderboardEntry* entry = &board->entries[slot];
+    if (root < 0) {
+        return slot;
+    }
+    if (entry->priority > board->entries[root].priority) {
+        split(board, root, entry, &entry->left, &entry->right);
+        pull_up(board, slot);
+        return slot;
+    }
+    if (ranks_before(entry, &board->entries[root])) {
+        board->entries[root].left = insert(board, board->entries[root].left, slot);
+    } else {
+        board->entries[root].right = insert(board, board->entries[root].right, slot);
+    }
+    pull_up(board, root);
+    return root;
+}
+
+static int erase(Leaderboard* board, int root, int slot) {
+    if (root == slot) {
+        return merge(board, board->entries[slot].left, board->entries[slot].right);
+    }
+    if (ranks_before(&board->entries[slot], &board->entries[root])) {
+        board->entries[root].left = erase(board, board->entries[root].left, slot);
+    } else {
+        board->entries[root].right = erase(board, board->entries[root].right, slot);
+    }
+    pull_up(board, root);
+    return root;
+}
+
+// Linking a detached slot into the tree with a fresh stamp, so it goes after the players already at its score
+static void link_entry(Leaderboard* board, int slot, int score) {
+    LeaderboardEntry* entry = &board->entries[slot];
+    entry->score = score;
+    entry->stamp = board->next_stamp++;
+    entry->left = entry->right = -1;
+    entry->count = 1;
+    board->root = insert(board, board->root, slot);
+    board->entries[board->root].parent = -1;
+}
+
+static void unlink_entry(Leaderboard* board, int slot) {
+    board->root = erase(board, board->root, slot);
+    if (board->root >= 0) {
+        board->entries[board->root].parent = -1;
+    }
+}
+
+// 0-based position of a slot: the entries before it in its own subtree and in every subtree it's on the right of
+static int position_of(Leaderboard* board, int slot) {
+    int position = count_of(board, board->entries[slot].left);
+    for (int parent = board->entries[slot].parent; parent >= 0; slot = parent, parent = board->entries[slot].parent) {
+        if (board->entries[parent].right == slot) {
+            position += count_of(board, board->entries[parent].left) + 1;
+        }
+    }
+    return position;
+}
+
+// The slot of a player still in the board, -1 otherwise
+static int slot_of(Leaderboard* board, Player* player) {
+    int slot = player->leaderboard_slot;
+    if (slot >= 0 && slot < board->slots && board->entries[slot].player == player) {
+        return slot;
+    }
+    return -1;
+}
+
+// The top K changes if the entry was in it or ended up in it
+static void track_top_change(Leaderboard* board, int old_position, int new_position) {
+    if (old_position < board->top_k || new_position < board->top_k) {
+        board->top_version++;
+    }
+}
+
+void leaderboard_add(Leaderboard* board, Player* player) {
+    pthread_mutex_lock(&board->mutex);
+
+    int slot = board->free_slot;
+    if (slot >= 0) {
+        board->free_slot = board->entries[slot].parent;
+    } else {
+        if (board->slots == board->capacity) {
+            int new_capacity = board->capacity * 2;
+            LeaderboardEntry* new_entries = realloc(board->entries, new_capacity * sizeof(LeaderboardEntry));
+            if (!new_entries) {
+                handle_error(MEMORY_ALLOCATION_ERROR);
+            }
+            board->entries = new_entries;
+            board->capacity = new_capacity;
+        }
+        slot = board->slots++;
+    }
+
+    board->entries[slot].player = player;
+    board->entries[slot].priority = rand_r(&board->seed);
+    player->leaderboard_slot = slot;
+    link_entry(board, slot, atomic_load(&player->score));
+    board->size++;
+    track_top_change(board, board->size - 1, position_of(board, slot));
+
+    pthread_mutex_unlock(&board->mutex);
+}
+
+void leaderboard_remove(Leaderboard* board, Player* player) {
+    pthread_mutex_lock(&board->mutex);
+
+    int slot = slot_of(board, player);
+    if (slot >= 0) {
+        int position = position_of(board, slot);
+        unlink_entry(board, slot);
+        board->entries[slot].player = NULL;
+        board->entries[slot].parent = board->free_slot;
+        board->free_slot = slot;
+        board->size--;
+        player->leaderboard_slot = -1;
+        track_top_change(board, position, board->size);
+    }
+
+    pthread_mutex_unlock(&board->mutex);
+}
+
+void leaderboard_update(Leaderboard* board, Player* player, int score) {
+    pthread_mutex_lock(&board->mutex);
+
+    int slot = slot_of(board, player);
+    if (slot >= 0 && board->entries[slot].score != score) {
+        int position = position_of(board, slot);
+        unlink_entry(board, slot);
+        link_entry(board, slot, score);
+        track_top_change(board, position, position_of(board, slot));
+    }
+
+    pthread_mutex_unlock(&board->mutex);
+}
+
+// Clearing every score at the start of a round, every player gets the next push.
+// Restamping in rank order keeps the tree ordered, so the standings carry over as the tie order.
+void leaderboard_reset(Leaderboard* board) {
+    pthread_mutex_lock(&board->mutex);
+    for (int slot = leaderboard_first(board); slot >= 0; slot = leaderboard_next(board, slot)) {
+        board->entries[slot].score = 0;
+        board->entries[slot].stamp = board->next_stamp++;
+        board->entries[slot].player->last_pushed_rank = 0;
+    }
+    board->top_version++;
+    pthread_mutex_unlock(&board->mutex);
+}
+
+// The caller must hold the board mutex. The slot of the first player, -1 if the board is empty
+int leaderboard_first(Leaderboard* board) {
+    int slot = board->root;
+    while (slot >= 0 && board->entries[slot].left >= 0) {
+        slot = board->entries[slot].left;
+    }
+    return slot;
+}
+
+// The caller must hold the board mutex. The slot ranked right after the given one, -1 after the last
+int leaderboard_next(Leaderboard* board, int slot) {
+    LeaderboardEntry* entry = &board->entries[slot];
+    if (entry->right >= 0) {
+        slot = entry->right;
+        while (board->entries[slot].left >= 0) {
+            slot = board->entries[slot].left;
+        }
+        return slot;
+    }
+    while (entry->parent >= 0 && board->entries[entry->parent].right == slot) {
+        slot = entry->parent;
+        entry = &board->entries[slot];
+    }
+    return entry->parent;
+}
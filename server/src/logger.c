@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "macros.h"
+#include "utils.h"
+
+#define LOG_LINE_SIZE (LOG_MESSAGE_SIZE + 32)
+#define LOG_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+atomic_int log_level = DEFAULT_LOG_LEVEL;
+
+static int log_fd = STDOUT_FILENO;
+static atomic_bool log_running = false;
+static atomic_long dropped_records = 0;
+
+static LogRing *rings = NULL;                                  // Never freed, only recycled
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER; // One drain at a time: writer thread or log_flush
+static pthread_mutex_t wakeup_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeup = PTHREAD_COND_INITIALIZER;
+static pthread_key_t ring_key;
+static __thread LogRing *thread_ring = NULL;
+
+static const char *level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static int format_line(char *line, long long timestamp_ns, LogLevel level, const char *text, int length) {
+    time_t seconds = timestamp_ns / 1000000000LL;
+    struct tm local;
+    localtime_r(&seconds, &local);
+    return snprintf(line, LOG_LINE_SIZE, "%02d:%02d:%02d.%06lld %-5s %.*s\n",
+                    local.tm_hour, local.tm_min, local.tm_sec, (timestamp_ns % 1000000000LL) / 1000,
+                    level_names[level], length, text);
+}
+
+static long long realtime_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Called when the owning thread exits, the writer still drains what's left in the ring
+static void release_ring(void *ring) {
+    atomic_store(&((LogRing *)ring)->in_use, false);
+}
+
+// Handing the calling thread an empty ring left by an exited thread, or a new one
+static LogRing* acquire_ring() {
+    pthread_mutex_lock(&rings_mutex);
+    LogRing *ring = rings;
+    while (ring && (atomic_load(&ring->in_use) || atomic_load(&ring->head) != atomic_load(&ring->tail))) {
+        ring = ring->next;
+    }
+    if (!ring) {
+        ring = calloc(1, sizeof(LogRing));
+        if (!ring) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+        ring->next = rings;
+        rings = ring;
+    }
+    atomic_store(&ring->in_use, true);
+    pthread_mutex_unlock(&rings_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    return ring;
+}
+
+// Writing out every pending record of every ring, records of one thread stay in order
+static void drain_rings() {
+    static char output[LOG_OUTPUT_BUFFER_SIZE];
+    size_t used = 0;
+
+    pthread_mutex_lock(&drain_mutex);
+    pthread_mutex_lock(&rings_mutex);
+    LogRing *first = rings;
+    pthread_mutex_unlock(&rings_mutex);
+
+    for (LogRing *ring = first; ring; ring = ring->next) {
+        unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        for (; tail != head; tail++) {
+            if (LOG_OUTPUT_BUFFER_SIZE - used < LOG_LINE_SIZE) {
+                write_all(log_fd, output, used);
+                used = 0;
+            }
+            LogRecord *record = &ring->records[tail % LOG_RING_SLOTS];
+            used += format_line(output + used, record->timestamp_ns, record->level, record->text, record->length);
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    if (used > 0) {
+        write_all(log_fd, output, used);
+    }
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+static void *log_writer_loop(void *arg) {
+    (void)arg;
+    while (1) {
+        drain_rings();
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LOG_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&wakeup_mutex);
+        pthread_cond_timedwait(&wakeup, &wakeup_mutex, &deadline);
+        pthread_mutex_unlock(&wakeup_mutex);
+    }
+    return NULL;
+}
+
+// Starting the writer thread, records logged before this are written synchronously
+void log_init(LogLevel level, int fd) {
+    atomic_store(&log_level, level);
+    log_fd = fd;
+    pthread_key_create(&ring_key, release_ring);
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, log_writer_loop, NULL);
+    pthread_detach(writer);
+
+    atomic_store(&log_running, true);
+    atexit(log_flush);
+}
+
+// Formatting into the calling thread's ring, the write itself happens on the writer thread
+void log_write(LogLevel level, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    if (!atomic_load_explicit(&log_running, memory_order_acquire)) {
+        char text[LOG_MESSAGE_SIZE];
+        char line[LOG_LINE_SIZE];
+        int length = vsnprintf(text, sizeof(text), format, args);
+        length = length < (int)sizeof(text) ? length : (int)sizeof(text) - 1;
+        write_all(log_fd, line, format_line(line, realtime_ns(), level, text, length));
+        va_end(args);
+        return;
+    }
+
+    LogRing *ring = thread_ring ? thread_ring : (thread_ring = acquire_ring());
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == LOG_RING_SLOTS) {
+        atomic_fetch_add_explicit(&dropped_records, 1, memory_order_relaxed);
+        va_end(args);
+        return;
+    }
+
+    LogRecord *record = &ring->records[head % LOG_RING_SLOTS];
+    record->timestamp_ns = realtime_ns();
+    record->level = level;
+    int length = vsnprintf(record->text, LOG_MESSAGE_SIZE, format, args);
+    record->length = length < LOG_MESSAGE_SIZE ? length : LOG_MESSAGE_SIZE - 1;
+    va_end(args);
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    // Waking the writer early instead of letting a busy thread fill its ring
+    if (head + 1 - tail == LOG_RING_SLOTS / 2 || level >= LOG_LEVEL_ERROR) {
+        pthread_cond_signal(&wakeup);
+    }
+}
+
+void log_flush() {
+    if (atomic_load(&log_running)) {
+        drain_rings();
+    }
+}
+
+long log_dropped() {
+    return atomic_load(&dropped_records);
+}
+
+bool parse_log_level(const char *name, LogLevel *level) {
+    static const char *names[] = { "debug", "info", "warn", "error" };
+    for (int i = 0; i <= LOG_LEVEL_ERROR; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,6 +1,8 @@
 #include "matrix_handler.h"
 #include "macros.h"
 #include "utils.h"
+#include "logger.h"
+#include "probes.h"
 
 
 #include <stdbool.h>
@@ -198,8 +200,22 @@ void print_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
     printf("\n\n");
 }
 
+// Logging the new matrix on one line, rows separated by '|'
+static void log_matrix(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char* source) {
+    char rows[MATRIX_SIZE * (MATRIX_SIZE * 3 + 2) + 1];
+    int length = 0;
+    for (int i = 0; i < MATRIX_SIZE; i++) {
+        for (int j = 0; j < MATRIX_SIZE; j++) {
+            length += snprintf(rows + length, sizeof(rows) - length, "%s ", matrix[i][j].letter);
+        }
+        if (i < MATRIX_SIZE - 1) {
+            length += snprintf(rows + length, sizeof(rows) - length, "| ");
+        }
+    }
+    LOG_INFO("Matrix generated from %s: %s", source, rows);
+}
+
 void init_matrix_from_file(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char* filename, int iteration) {
-    printf("\nGenerating matrix...\n\n");
 
     FILE* file = fopen(filename, "r");
     if (!file) {
@@ -253,16 +269,13 @@ void init_matrix_from_file(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], const char* fi
         handle_error(FILE_SIZE_ERROR);
     }
 
-    printf("Matrix generated from file '%s':\n", filename);
-    print_matrix(matrix);
+    log_matrix(matrix, filename);
 
     fclose(file);
 }
 
 
 void init_matrix_random(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
-    printf("\nGenerating random matrix...\n\n");
-
     for (int i = 0; i < MATRIX_SIZE; i++) {
         for (int j = 0; j < MATRIX_SIZE; j++) {
             const char letter = get_random_letter();
@@ -275,7 +288,7 @@ void init_matrix_random(Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
         }
     }
 
-    print_matrix(matrix); 
+    log_matrix(matrix, "random letters");
 }
 
 TrieNode* create_node(void) {
@@ -304,6 +317,7 @@ void add_word(TrieNode *root, const char *word) {
 }
 
 TrieNode* init_dictionary(const char *filename) {
+    PROBE1(dictionary__load__start, filename);
     TrieNode *root = create_node();
     FILE *file = fopen(filename, "r");
     if (!file) {
@@ -313,7 +327,8 @@ TrieNode* init_dictionary(const char *filename) {
     char word[256];
     size_t word_count = 0;
 
-    printf("Loading dictionary...\n");
+    LOG_INFO("Loading dictionary...");
+    long long load_start_ms = monotonic_ms();
     while (fgets(word, sizeof(word), file)) {
         size_t len = strlen(word);
         if (len > 0 && word[len - 1] == '\n') {
@@ -324,7 +339,8 @@ TrieNode* init_dictionary(const char *filename) {
     }
 
     fclose(file);
-    printf("Dictionary loaded: %zu words\n", word_count);
+    LOG_INFO("Dictionary loaded: %zu words in %lld ms", word_count, monotonic_ms() - load_start_ms);
+    PROBE1(dictionary__load__end, word_count);
 
     return root;
 }
@@ -354,11 +370,3 @@ void free_dictionary(TrieNode *node) {
         free(node);
     }
 }
-
-void send_matrix_to_all(PlayerArray *players_array, Cell matrix[MATRIX_SIZE][MATRIX_SIZE]) {
-    for (int i = 0; i < players_array->size; i++) {
-        send_matrix_to_client(players_array->players[i].fd);
-    }
-}
-
-
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "metrics.h"
+#include "macros.h"
+#include "utils.h"
+#include "logger.h"
+
+#define METRICS_BUFFER_SIZE (16 * 1024)
+
+static Metric metrics[MAX_METRICS];
+static int metrics_count = 0;
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER; // Only taken to register and to scrape
+
+static Metric* register_metric(const char *name, const char *labels, const char *help, MetricKind kind) {
+    pthread_mutex_lock(&metrics_mutex);
+    if (metrics_count == MAX_METRICS) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    Metric *metric = &metrics[metrics_count++];
+    metric->name = name;
+    metric->labels = labels;
+    metric->help = help;
+    metric->kind = kind;
+    atomic_init(&metric->value, 0);
+    metric->read = NULL;
+    metric->histogram = NULL;
+    pthread_mutex_unlock(&metrics_mutex);
+    return metric;
+}
+
+Metric* metrics_counter(const char *name, const char *labels, const char *help) {
+    return register_metric(name, labels, help, METRIC_COUNTER);
+}
+
+// A counter kept by another module, read when scraped: the read must never go down
+Metric* metrics_read_counter(const char *name, const char *labels, const char *help, long (*read)(void)) {
+    Metric *metric = register_metric(name, labels, help, METRIC_COUNTER);
+    metric->read = read;
+    return metric;
+}
+
+Metric* metrics_gauge(const char *name, const char *labels, const char *help, long (*read)(void)) {
+    Metric *metric = register_metric(name, labels, help, METRIC_GAUGE);
+    metric->read = read;
+    return metric;
+}
+
+Metric* metrics_histogram(const char *name, const char *labels, const char *help) {
+    Metric *metric = register_metric(name, labels, help, METRIC_HISTOGRAM);
+    metric->histogram = calloc(1, sizeof(Histogram));
+    if (!metric->histogram) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    return metric;
+}
+
+// Values below HISTOGRAM_SUB_BUCKETS get a bucket each, above that every power of two is split in HISTOGRAM_SUB_BUCKETS
+static int bucket_index(unsigned long long value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BUCKET_BITS;
+    return shift * HISTOGRAM_SUB_BUCKETS + (int)(value >> shift);
+}
+
+// Exclusive upper bound of the values counted in a bucket
+static unsigned long long bucket_upper_bound(int index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index + 1;
+    }
+    int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long long sub_bucket = index % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS;
+    return (sub_bucket + 1) << shift;
+}
+
+void histogram_record(Metric *metric, long long value_ns) {
+    Histogram *histogram = metric->histogram;
+    int index = bucket_index(value_ns > 0 ? value_ns : 0);
+    atomic_fetch_add_explicit(&histogram->buckets[index], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum_ns, value_ns, memory_order_relaxed);
+}
+
+// Upper bound of the bucket holding the quantile, so the result overestimates by at most one bucket width
+long long histogram_quantile(Metric *metric, double quantile) {
+    Histogram *histogram = metric->histogram;
+    long count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    if (count == 0) return 0;
+
+    long target = (long)(quantile * count);
+    if (target >= count) target = count - 1;
+    long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if (seen > target) return bucket_upper_bound(i);
+    }
+    return bucket_upper_bound(HISTOGRAM_BUCKETS - 1);
+}
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} TextBuffer;
+
+static void append(TextBuffer *text, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void append(TextBuffer *text, const char *format, ...) {
+    while (1) {
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(text->data + text->size, text->capacity - text->size, format, args);
+        va_end(args);
+
+        if (written >= 0 && (size_t)written < text->capacity - text->size) {
+            text->size += written;
+            return;
+        }
+        text->capacity *= 2;
+        text->data = realloc(text->data, text->capacity);
+        if (!text->data) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+    }
+}
+
+// Writing the labels of a series, with an extra label (e.g. le="0.001") when given
+static void append_labels(TextBuffer *text, const char *labels, const char *extra) {
+    bool has_labels = labels && labels[0];
+    if (!has_labels && !extra) return;
+    append(text, "{%s%s%s}", has_labels ? labels : "", has_labels && extra ? "," : "", extra ? extra : "");
+}
+
+static void render_histogram(TextBuffer *text, Metric *metric) {
+    Histogram *histogram = metric->histogram;
+    long cumulative = 0;
+    char le[48];
+
+    // Only the buckets with samples are listed, the cumulative counts stay correct
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        long bucket = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if (bucket == 0) continue;
+        cumulative += bucket;
+        snprintf(le, sizeof(le), "le=\"%.9g\"", bucket_upper_bound(i) / 1e9);
+        append(text, "%s_bucket", metric->name);
+        append_labels(text, metric->labels, le);
+        append(text, " %ld\n", cumulative);
+    }
+    append(text, "%s_bucket", metric->name);
+    append_labels(text, metric->labels, "le=\"+Inf\"");
+    append(text, " %ld\n", cumulative);
+
+    append(text, "%s_sum", metric->name);
+    append_labels(text, metric->labels, NULL);
+    append(text, " %.9f\n", atomic_load_explicit(&histogram->sum_ns, memory_order_relaxed) / 1e9);
+    append(text, "%s_count", metric->name);
+    append_labels(text, metric->labels, NULL);
+    append(text, " %ld\n", cumulative);
+}
+
+// Rendering every metric in the Prometheus text format, the caller frees the buffer
+size_t metrics_render(char **buffer) {
+    static const char *kind_names[] = { "counter", "gauge", "histogram" };
+    TextBuffer text = { .data = malloc(METRICS_BUFFER_SIZE), .size = 0, .capacity = METRICS_BUFFER_SIZE };
+    if (!text.data) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    text.data[0] = '\0';
+
+    pthread_mutex_lock(&metrics_mutex);
+    for (int i = 0; i < metrics_count; i++) {
+        Metric *metric = &metrics[i];
+        if (i == 0 || strcmp(metrics[i - 1].name, metric->name) != 0) {
+            append(&text, "# HELP %s %s\n# TYPE %s %s\n", metric->name, metric->help, metric->name, kind_names[metric->kind]);
+        }
+
+        if (metric->kind == METRIC_HISTOGRAM) {
+            render_histogram(&text, metric);
+        } else {
+            long value = metric->read ? metric->read() : atomic_load_explicit(&metric->value, memory_order_relaxed);
+            append(&text, "%s", metric->name);
+            append_labels(&text, metric->labels, NULL);
+            append(&text, " %ld\n", value);
+        }
+    }
+    pthread_mutex_unlock(&metrics_mutex);
+
+    *buffer = text.data;
+    return text.size;
+}
+
+// Every connection to the admin socket receives the current metrics, then it's closed
+static void* admin_server_loop(void *arg) {
+    int admin_fd = (int)(long)arg;
+    while (1) {
+        int client_fd = accept(admin_fd, NULL, NULL);
+        if (client_fd == -1) {
+            LOG_WARN("Admin socket accept failed");
+            continue;
+        }
+
+        char *buffer;
+        size_t size = metrics_render(&buffer);
+        write_all(client_fd, buffer, size);
+        free(buffer);
+        close(client_fd);
+    }
+    return NULL;
+}
+
+void start_admin_server(const char *socket_path) {
+    struct sockaddr_un admin_addr = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(admin_addr.sun_path)) {
+        handle_error(CONFIG_ERROR_VALUE);
+    }
+    strcpy(admin_addr.sun_path, socket_path);
+
+    int admin_fd, last_ret_value;
+    SYSC(admin_fd, socket(AF_UNIX, SOCK_STREAM, 0), "Admin socket creation failed");
+    unlink(socket_path); // A socket left by a previous run would make bind fail
+    SYSC(last_ret_value, bind(admin_fd, (struct sockaddr *)&admin_addr, sizeof(admin_addr)), "Admin socket bind failed");
+    SYSC(last_ret_value, listen(admin_fd, 8), "Admin socket listen failed");
+
+    pthread_t admin_thread;
+    pthread_create(&admin_thread, NULL, admin_server_loop, (void *)(long)admin_fd);
+    pthread_detach(admin_thread);
+    LOG_INFO("Metrics available on %s", socket_path);
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "mpmc_queue.h"
+#include "macros.h"
+#include "utils.h"
+
+// The capacity is rounded up to a power of two so a position maps to its slot with a mask
+MpmcQueue* mpmc_create(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+
+    MpmcQueue *queue = aligned_alloc(CACHE_LINE_SIZE, sizeof(MpmcQueue));
+    if (!queue) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    queue->slots = malloc(size * sizeof(MpmcSlot));
+    if (!queue->slots) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    queue->mask = size - 1;
+    atomic_init(&queue->enqueue_position, 0);
+    atomic_init(&queue->dequeue_position, 0);
+    return queue;
+}
+
+// Failing when the queue is full
+bool mpmc_push(MpmcQueue *queue, void *item) {
+    size_t position = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    while (1) {
+        MpmcSlot *slot = &queue->slots[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if (difference == 0) {
+            // The slot is free for this lap, claiming the position (a failed CAS reloads it)
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->item = item;
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false; // The consumer of the previous lap hasn't emptied the slot yet
+        } else {
+            position = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+        }
+    }
+}
+
+// Failing when the queue is empty
+bool mpmc_pop(MpmcQueue *queue, void **item) {
+    size_t position = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    while (1) {
+        MpmcSlot *slot = &queue->slots[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *item = slot->item;
+                // Freeing the slot for the producer of the next lap
+                atomic_store_explicit(&slot->sequence, position + queue->mask + 1, memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+        }
+    }
+}
+
+// Approximate while producers and consumers are running, good enough for a depth gauge
+size_t mpmc_size(MpmcQueue *queue) {
+    size_t enqueued = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    size_t dequeued = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
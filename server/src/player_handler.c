@@ -2,47 +2,52 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <unistd.h>
 
 #include "player_handler.h"
 #include "utils.h"
 #include "macros.h"
+#include "logger.h"
 
-ScoresList* create_player_score_list(int length) {
-    ScoresList* list = malloc(sizeof(PlayerScore));
+// The list and its entries live in the round arena, they are released by arena_reset
+ScoresList* create_player_score_list(Arena* arena, int length) {
+    ScoresList* list = arena_alloc(arena, sizeof(ScoresList));
 
-    list->players = malloc(length * sizeof(PlayerScore));
+    list->players = arena_alloc(arena, length * sizeof(PlayerScore));
     list->size = 0;
 
     return list;
 }
 
-PlayerScore* add_player_score(ScoresList* score_list, char* username, int score) {
-    
-    // Initialize new player
-    PlayerScore *newPlayer = (PlayerScore *)malloc(sizeof(Player));
+PlayerScore* add_player_score(ScoresList* score_list, const char* username, int score) {
+
+    // Filling the next free slot of the list
+    PlayerScore *newPlayer = &score_list->players[score_list->size++];
     strcpy(newPlayer->username, username);
     newPlayer->score = score;
 
-    // Add the new player to the list
-    score_list->players[score_list->size++] = *newPlayer;
-
-    // no need to free the memory allocated for the name because it's copied
     return newPlayer;
 }
 
-void free_player_score_list(ScoresList* list) {
-    free(list->players);
-    free(list);
+// Copying the current score of every registered player, scores are read atomically
+ScoresList* snapshot_player_scores(PlayerArray* registry, Arena* arena) {
+    pthread_rwlock_rdlock(&registry->lock);
+    ScoresList* list = create_player_score_list(arena, registry->size);
+    for (int i = 0; i < registry->size; i++) {
+        add_player_score(list, registry->players[i]->username, atomic_load(&registry->players[i]->score));
+    }
+    pthread_rwlock_unlock(&registry->lock);
+    return list;
 }
 
 
-PlayerArray* create_player_registry() {
+PlayerArray* create_player_registry(int max_size) {
     PlayerArray* registry = malloc(sizeof(PlayerArray));
     if (!registry) {
         fprintf(stderr, "Failed to allocate memory for PlayerArray\n");
         exit(EXIT_FAILURE);
     }
-    registry->players = malloc(INITIAL_PLAYER_CAPACITY * sizeof(Player));
+    registry->players = malloc(INITIAL_PLAYER_CAPACITY * sizeof(Player*));
     if (!registry->players) {
         fprintf(stderr, "Failed to allocate memory for players array\n");
         free(registry);
@@ -50,12 +55,14 @@ PlayerArray* create_player_registry() {
     }
     registry->size = 0;
     registry->capacity = INITIAL_PLAYER_CAPACITY;
+    registry->max_size = max_size;
+    pthread_rwlock_init(&registry->lock, NULL);
     return registry;
 }
 
 void expand_player_registry(PlayerArray* registry) {
     int new_capacity = registry->capacity * 2;
-    Player* new_players = realloc(registry->players, new_capacity * sizeof(Player));
+    Player** new_players = realloc(registry->players, new_capacity * sizeof(Player*));
     if (!new_players) {
         fprintf(stderr, "Failed to expand player registry\n");
         exit(EXIT_FAILURE);
@@ -64,95 +71,148 @@ void expand_player_registry(PlayerArray* registry) {
     registry->capacity = new_capacity;
 }
 
-Player* add_player(PlayerArray* registry, int fd, pthread_t tid, const char* username) {
-
-    if (registry->size == MAX_PLAYERS) {
-        fprintf(stderr, "Player tried to register - LIMIT REACHED\n");
-        return NULL;
-    }
+static atomic_int next_connection_id = 1; // 0 is NO_CONNECTION in the flight recorder
 
-    if (registry->size == registry->capacity) {
-        expand_player_registry(registry);
+Player* create_player(int fd) {
+    Player* player = malloc(sizeof(Player));
+    if (!player) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
     }
-    
-    Player* player = &registry->players[registry->size++];
+    player->username[0] = '\0';
     player->fd = fd;
-    player->tid = tid;
-    strncpy(player->username, username, MAX_USERNAME_LENGTH - 1);
-    player->username[MAX_USERNAME_LENGTH - 1] = '\0';
-    player->score = 0;
-    player->words = malloc(INITIAL_WORD_CAPACITY * sizeof(char*));
+    player->connection_id = atomic_fetch_add(&next_connection_id, 1);
+    atomic_init(&player->is_registered, false);
+    atomic_init(&player->score, 0);
+    player->words = NULL;
     player->word_size = 0;
-    player->word_capacity = INITIAL_WORD_CAPACITY;
+    player->word_capacity = 0;
+    player->leaderboard_slot = -1;
+    player->last_pushed_rank = 0;
+    atomic_init(&player->references, 1);
+    pthread_mutex_init(&player->send_lock, NULL);
+    return player;
+}
 
-    printf("Player %s registered with fd %d\n", player->username, player->fd);
-    // print all the players in the registry
-    for (int i = 0; i < registry->size; i++) {
-        printf("Player %d: %s\n", i, registry->players[i].username);
+// Must be called once the player is no longer in the registry
+void destroy_player(Player* player) {
+    pthread_mutex_destroy(&player->send_lock);
+    free(player);
+}
+
+// Only while the player is reachable: in the registry, under its lock
+void retain_player(Player* player) {
+    atomic_fetch_add_explicit(&player->references, 1, memory_order_relaxed);
+}
+
+// The last reference closes the socket, so its fd can't be reused under a broadcast still writing to it
+void release_player(Player* player) {
+    if (atomic_fetch_sub_explicit(&player->references, 1, memory_order_acq_rel) == 1) {
+        close(player->fd);
+        destroy_player(player);
     }
-    
-    return player;
 }
 
-void remove_player(PlayerArray* registry, int fd) {
+// Checking and inserting under the same write lock, so two clients can't grab the same username
+Error add_player(PlayerArray* registry, Player* player, const char* username) {
+    pthread_rwlock_wrlock(&registry->lock);
+
+    Error result = SUCCESS;
+    if (atomic_load(&player->is_registered)) {
+        result = ALREADY_REGISTERED_ERROR;
+    } else if (is_username_taken(registry, username)) {
+        result = USERNAME_TAKEN_ERROR;
+    } else if (registry->size == registry->max_size) {
+        LOG_WARN("Player tried to register - LIMIT REACHED");
+        result = MAX_PLAYERS_ERROR;
+    } else {
+        if (registry->size == registry->capacity) {
+            expand_player_registry(registry);
+        }
+
+        strncpy(player->username, username, MAX_USERNAME_LENGTH - 1);
+        player->username[MAX_USERNAME_LENGTH - 1] = '\0';
+        reset_player_round(player);
+        registry->players[registry->size++] = player;
+        atomic_store(&player->is_registered, true);
+
+        LOG_INFO("Player %s registered with fd %d, %d players registered", player->username, player->fd, registry->size);
+    }
+
+    pthread_rwlock_unlock(&registry->lock);
+    return result;
+}
+
+void remove_player(PlayerArray* registry, Player* player) {
+    pthread_rwlock_wrlock(&registry->lock);
     for (int i = 0; i < registry->size; i++) {
-        if (registry->players[i].fd == fd) {
-            for (int j = 0; j < registry->players[i].word_size; j++) {
-                free(registry->players[i].words[j]);
-            }
-            free(registry->players[i].words);
-            
-            memmove(&registry->players[i], &registry->players[i+1], 
-                    (registry->size - i - 1) * sizeof(Player));
+        if (registry->players[i] == player) {
+            // Words belong to the round arena, nothing to free here
+            memmove(&registry->players[i], &registry->players[i+1],
+                    (registry->size - i - 1) * sizeof(Player*));
             registry->size--;
-            return;
+            atomic_store(&player->is_registered, false);
+            break;
         }
     }
+    pthread_rwlock_unlock(&registry->lock);
 }
 
+// The returned pointer is only valid while the player is connected
 Player* find_player(PlayerArray* registry, int fd) {
+    Player* found = NULL;
+    pthread_rwlock_rdlock(&registry->lock);
     for (int i = 0; i < registry->size; i++) {
-        if (registry->players[i].fd == fd) {
-            return &registry->players[i];
+        if (registry->players[i]->fd == fd) {
+            found = registry->players[i];
+            break;
         }
     }
-    return NULL;
+    pthread_rwlock_unlock(&registry->lock);
+    return found;
 }
 
 void update_player_score(Player* player, int points_gained) {
     if (player) {
-        player->score = player->score + points_gained;
+        atomic_fetch_add(&player->score, points_gained);
     }
 }
 
+// The caller must hold the registry lock
 bool is_username_taken(PlayerArray* registry, const char* username) {
     for (int i = 0; i < registry->size; i++) {
-        if (strcmp(registry->players[i].username, username) == 0) {
+        if (strcmp(registry->players[i]->username, username) == 0) {
             return true;
         }
     }
     return false;
 }
 
-void add_word_to_player(Player* player, const char* word) {
+// Clearing the per-round data of a player, the old words are released with the round arena. Room thread only
+void reset_player_round(Player* player) {
+    atomic_store(&player->score, 0);
+    player->words = NULL;
+    player->word_size = 0;
+    player->word_capacity = 0;
+}
+
+// Room thread only, like every access to the player's words
+void add_word_to_player(Arena* arena, Player* player, const char* word) {
     if (player->word_size == player->word_capacity) {
-        player->word_capacity *= 2;
-        player->words = realloc(player->words, player->word_capacity * sizeof(char*));
-        if (!player->words) {
-            fprintf(stderr, "Failed to expand word list for player\n");
-            exit(EXIT_FAILURE);
+        // Growing inside the arena: the old array is simply abandoned until the round ends
+        int new_capacity = player->word_capacity ? player->word_capacity * 2 : INITIAL_WORD_CAPACITY;
+        char** new_words = arena_alloc(arena, new_capacity * sizeof(char*));
+        if (player->word_size > 0) {
+            memcpy(new_words, player->words, player->word_size * sizeof(char*));
         }
+        player->words = new_words;
+        player->word_capacity = new_capacity;
     }
-    
-    player->words[player->word_size] = strdup(word);
-    if (!player->words[player->word_size]) {
-        fprintf(stderr, "Failed to duplicate word\n");
-        exit(EXIT_FAILURE);
-    }
-    player->word_size++;
+
+    player->words[player->word_size++] = arena_strdup(arena, word);
 }
 
-bool has_player_used_word(Player* player, char* word) {
+// Room thread only
+bool has_player_used_word(Player* player, const char* word) {
     for (int i = 0; i < player->word_size; i++) {
         if (strcmp(player->words[i], word) == 0) {
             return true;
@@ -161,12 +221,17 @@ bool has_player_used_word(Player* player, char* word) {
     return false;
 }
 
+// Recording a word for the player unless it was already found this round, returns true if it's new. Room thread only
+bool add_word_if_new(Arena* arena, Player* player, const char* word) {
+    bool is_new = !has_player_used_word(player, word);
+    if (is_new) {
+        add_word_to_player(arena, player, word);
+    }
+    return is_new;
+}
+
 int sort_helper_players(const void* a, const void* b) {
-    Player* player_a = (Player*)a;
-    Player* player_b = (Player*)b;
+    PlayerScore* player_a = (PlayerScore*)a;
+    PlayerScore* player_b = (PlayerScore*)b;
     return player_b->score - player_a->score;
 }
-
-void sort_players_by_score(PlayerArray* registry) {
-    qsort(registry->players, registry->size, sizeof(Player), sort_helper_players);
-}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "room.h"
+#include "macros.h"
+#include "utils.h"
+
+static pthread_key_t queues_key;
+static pthread_once_t queues_key_once = PTHREAD_ONCE_INIT;
+static __thread RoomQueue *thread_queues = NULL; // Queues of the calling thread, one per room it posted to
+
+// Called when a producer thread exits, its queues go back to their rooms
+static void release_queues(void *queues) {
+    RoomQueue *queue = (RoomQueue *)queues;
+    while (queue) {
+        // Read before the release, another thread may take the queue and relink it right after
+        RoomQueue *next = queue->thread_next;
+        atomic_store(&queue->in_use, false);
+        queue = next;
+    }
+}
+
+static void create_queues_key() {
+    pthread_key_create(&queues_key, release_queues);
+}
+
+// Handing the calling thread its queue to the room: an emptied one left by an exited thread, or a new one
+static RoomQueue* thread_queue(Room *room) {
+    for (RoomQueue *queue = thread_queues; queue; queue = queue->thread_next) {
+        if (queue->room == room) return queue;
+    }
+    pthread_once(&queues_key_once, create_queues_key);
+
+    pthread_mutex_lock(&room->queues_mutex);
+    RoomQueue *queue = atomic_load(&room->queues);
+    while (queue && (atomic_load(&queue->in_use) || atomic_load(&queue->head) != atomic_load(&queue->tail))) {
+        queue = queue->next;
+    }
+    if (!queue) {
+        queue = aligned_alloc(CACHE_LINE_SIZE, sizeof(RoomQueue));
+        if (!queue) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+        memset(queue, 0, sizeof(RoomQueue));
+        sem_init(&queue->space, 0, 0);
+        queue->room = room;
+        queue->next = atomic_load(&room->queues);
+        atomic_store(&room->queues, queue); // Published whole, the room thread may walk the list right away
+    }
+    atomic_store(&queue->in_use, true);
+    pthread_mutex_unlock(&room->queues_mutex);
+
+    queue->thread_next = thread_queues;
+    thread_queues = queue;
+    pthread_setspecific(queues_key, thread_queues);
+    return queue;
+}
+
+static void wake_room(Room *room) {
+    if (atomic_load(&room->sleeping) && atomic_exchange(&room->sleeping, false)) {
+        sem_post(&room->wakeup);
+    }
+}
+
+// Sleeping until the room has handled some of the events of a full queue.
+// The flag is raised before the last look at the tail, paired with the room reading it after moving the tail:
+// either this thread sees the room's progress or the room sees the flag and posts. A stale post only costs a loop.
+static void wait_for_space(RoomQueue *queue, unsigned int head) {
+    while (head - atomic_load(&queue->tail) == ROOM_QUEUE_SLOTS) {
+        atomic_store(&queue->producer_waiting, true);
+        wake_room(queue->room);
+        if (head - atomic_load(&queue->tail) == ROOM_QUEUE_SLOTS) {
+            while (sem_wait(&queue->space) == -1 && errno == EINTR);
+        }
+    }
+}
+
+// Lock-free once the thread has its queue, the event is handled later on the room thread
+void room_post(Room *room, int type, void *data) {
+    RoomQueue *queue = thread_queue(room);
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&queue->tail, memory_order_acquire) == ROOM_QUEUE_SLOTS) {
+        wait_for_space(queue, head);
+    }
+
+    queue->events[head % ROOM_QUEUE_SLOTS] = (RoomEvent){ .type = type, .data = data };
+    // Sequentially consistent, paired with the room announcing its sleep before its last look at the queues
+    atomic_store(&queue->head, head + 1);
+    wake_room(room);
+}
+
+// Handling every pending event, events from one thread are handled in the order they were posted
+static long drain_queues(Room *room) {
+    long processed = 0;
+    for (RoomQueue *queue = atomic_load(&room->queues); queue; queue = queue->next) {
+        unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        unsigned int head = atomic_load(&queue->head);
+        for (; tail != head; tail++) {
+            room->handle_event(&queue->events[tail % ROOM_QUEUE_SLOTS]);
+            processed++;
+        }
+        atomic_store(&queue->tail, tail); // Sequentially consistent, paired with wait_for_space
+        if (atomic_load(&queue->producer_waiting) && atomic_exchange(&queue->producer_waiting, false)) {
+            sem_post(&queue->space);
+        }
+    }
+    atomic_fetch_add_explicit(&room->events_processed, processed, memory_order_relaxed);
+    return processed;
+}
+
+static void wait_for_wakeup(Room *room, long long deadline_ms) {
+    if (deadline_ms < 0) {
+        while (sem_wait(&room->wakeup) == -1 && errno == EINTR);
+        return;
+    }
+    // sem_timedwait takes a wall clock time, the monotonic deadline is moved onto it
+    long long remaining_ms = deadline_ms - monotonic_ms();
+    if (remaining_ms <= 0) return;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    long long nanoseconds = deadline.tv_nsec + (remaining_ms % 1000) * 1000000LL;
+    deadline.tv_sec += remaining_ms / 1000 + nanoseconds / 1000000000LL;
+    deadline.tv_nsec = nanoseconds % 1000000000LL;
+    while (sem_timedwait(&room->wakeup, &deadline) == -1 && errno == EINTR);
+}
+
+static void* room_loop(void *arg) {
+    Room *room = (Room *)arg;
+    while (1) {
+        long long next_tick_ms = room->next_tick_ms();
+        if (next_tick_ms >= 0 && monotonic_ms() >= next_tick_ms) {
+            room->tick();
+            continue;
+        }
+        if (drain_queues(room) > 0) {
+            continue;
+        }
+
+        // Announcing the sleep before looking at the queues one last time, so no post can be missed
+        atomic_store(&room->sleeping, true);
+        if (drain_queues(room) == 0) {
+            wait_for_wakeup(room, next_tick_ms);
+        }
+        atomic_store(&room->sleeping, false);
+    }
+    return NULL;
+}
+
+Room* room_create(void (*handle_event)(RoomEvent *event), long long (*next_tick_ms)(void), void (*tick)(void)) {
+    Room *room = malloc(sizeof(Room));
+    if (!room) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    room->handle_event = handle_event;
+    room->next_tick_ms = next_tick_ms;
+    room->tick = tick;
+    atomic_init(&room->queues, NULL);
+    pthread_mutex_init(&room->queues_mutex, NULL);
+    atomic_init(&room->sleeping, false);
+    sem_init(&room->wakeup, 0, 0);
+    atomic_init(&room->events_processed, 0);
+
+    pthread_t room_thread;
+    pthread_create(&room_thread, NULL, room_loop, room);
+    pthread_detach(room_thread);
+    return room;
+}
@@ -3,62 +3,216 @@
 #include "utils.h"
 #include "matrix_handler.h"
 #include "player_handler.h"
+#include "arena.h"
+#include "leaderboard.h"
+#include "logger.h"
+#include "probes.h"
+#include "simulation.h"
+#include "allocation_counter.h"
+#include "validation_pool.h"
+#include "room.h"
+#include "verdict_cache.h"
+#include "broadcast.h"
 
 #define MAX_CONF_LINE_LENGTH 64
 
 // ---- GLOBAL VARS ----
 
-// The game state is volatile to ensure it is always read from memory and not cached by the compiler.
-volatile GameState game_state = WAITING_STATE;
-
-// Initializing flags for game states and synchronization.
-bool is_game_ended = false;
-bool is_scores_list_ready = false;
-bool is_csv_results_scoreboard_ready = false;
 int match_duration; // This will store the duration of the game in seconds.
+int waiting_duration; // Seconds between two games, the first waiting phase is at most PRE_GAME_DURATION.
 int game_iteration = 0; // Tracking the number of games played, used for matrix generation.
 char* matrix_file_global; // This will hold the path to the file from which the matrix is generated.
-char csv_result[MAX_CSV_LENGTH] = ""; // Buffer to store the CSV formatted final scores.
-
-// Declaring condition variables and mutexes for synchronizing game state and player actions.
-pthread_cond_t game_over_condition = PTHREAD_COND_INITIALIZER; 
-pthread_cond_t scores_list_condition = PTHREAD_COND_INITIALIZER;
-pthread_cond_t csv_results_condition = PTHREAD_COND_INITIALIZER; 
-pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t time_mutex = PTHREAD_MUTEX_INITIALIZER;
+EncodedScoreboard final_scoreboard = {0}; // Final scores (in the round arena), encoded once as ready-to-send frames.
 
 ScoresList *scores_list = NULL; // Initializing the list of player scores.
 TrieNode* dictionary_root = NULL; // This will point to the root of the Trie for dictionary lookups.
 PlayerArray *players_array = NULL; // Array to keep track of players in the game.
-// Defining the game matrix, which is a grid of letters used to form words.
-Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
+Arena *round_arena = NULL; // Every per-round allocation (words, scores, scoreboard) lives here.
+Leaderboard *leaderboard = NULL; // Live standings, updated on every scored word.
+Config config; // Loaded from config.txt at startup.
+ValidationPool *validation_pool = NULL; // Workers validating the submitted words.
+VerdictCache *dictionary_cache = NULL; // Dictionary verdicts of the words submitted so far, across rounds.
+BroadcastSender *broadcast_sender = NULL; // Writes the room's broadcasts, so the room never waits on a socket.
+_Atomic(Room*) room = NULL; // Owns the game: rounds, registrations, the players' words and scores. Started after the metrics.
+
+// In a simulation the rounds follow a virtual clock, moved forward by advance_round only.
+static bool simulated_clock = false;
+static atomic_llong simulated_now_ms = 0;
+
+// Events handled by the room thread.
+typedef enum {
+    ROOM_JOIN,      // RoomRequest
+    ROOM_LEAVE,     // RoomRequest
+    ROOM_WORD,      // ValidationJob, already checked against the matrix and the dictionary
+    ROOM_ADVANCE    // RoomRequest, simulation only
+} RoomEventType;
+
+// A request waiting on its sender's stack until the room posts done.
+typedef struct {
+    Player *player;
+    const char *username;
+    Error result;
+    sem_t done;
+} RoomRequest;
+
+// ---- METRICS ----
+
+static Metric *connections_total, *clients_connected, *rounds_total;
+static Metric *words_valid, *words_duplicate, *words_invalid, *words_rejected;
+static Metric *registration_duration, *matrix_duration, *word_duration, *other_duration;
+static Metric *transition_duration, *scoreboard_encode_duration;
+static Metric *registration_allocations, *matrix_allocations, *word_allocations, *other_allocations;
+static Metric *validation_wait_duration;
+static Metric *dictionary_cache_hits, *dictionary_cache_misses;
+static Metric *slow_clients_disconnected;
+
+static long read_players_registered() {
+    pthread_rwlock_rdlock(&players_array->lock);
+    long size = players_array->size;
+    pthread_rwlock_unlock(&players_array->lock);
+    return size;
+}
+
+// Where submissions are waiting: queued for a worker, being validated, or validated with the reply not written yet.
+static long read_validation_queued() { return mpmc_size(validation_pool->queue); }
+static long read_validation_busy() { return atomic_load(&validation_pool->busy_workers); }
+static long read_replies_pending() { return atomic_load(&validation_pool->replies_pending); }
+
+static long read_room_events() {
+    Room *started = atomic_load(&room);
+    return started ? atomic_load_explicit(&started->events_processed, memory_order_relaxed) : 0;
+}
+static long read_dictionary_cache_entries() { return atomic_load_explicit(&dictionary_cache->entries, memory_order_relaxed); }
+static long read_dictionary_cache_evictions() { return atomic_load_explicit(&dictionary_cache->evictions, memory_order_relaxed); }
+static long read_round_arena_bytes() { return arena_bytes_used(round_arena); }
+static long read_log_records_dropped() { return log_dropped(); }
+
+// Registering every server metric, series of the same family are kept together.
+static void init_metrics() {
+    connections_total = metrics_counter("paroliere_connections_total", NULL, "Client connections accepted");
+    clients_connected = metrics_gauge("paroliere_clients_connected", NULL, "Clients currently connected", NULL);
+    metrics_gauge("paroliere_players_registered", NULL, "Players currently registered", read_players_registered);
+    rounds_total = metrics_counter("paroliere_rounds_total", NULL, "Rounds played to the end");
+    words_valid = metrics_counter("paroliere_words_total", "result=\"valid\"", "Word submissions by result");
+    words_duplicate = metrics_counter("paroliere_words_total", "result=\"duplicate\"", "Word submissions by result");
+    words_invalid = metrics_counter("paroliere_words_total", "result=\"invalid\"", "Word submissions by result");
+    words_rejected = metrics_counter("paroliere_words_total", "result=\"rejected\"", "Word submissions by result");
+    registration_duration = metrics_histogram("paroliere_request_duration_seconds", "type=\"registra_utente\"", "Time to handle a client request");
+    matrix_duration = metrics_histogram("paroliere_request_duration_seconds", "type=\"matrice\"", "Time to handle a client request");
+    word_duration = metrics_histogram("paroliere_request_duration_seconds", "type=\"parola\"", "Time to handle a client request");
+    other_duration = metrics_histogram("paroliere_request_duration_seconds", "type=\"other\"", "Time to handle a client request");
+    if (ALLOCATION_COUNTING) { // Only counting builds have the numbers, the others leave the metric out
+        registration_allocations = metrics_counter("paroliere_request_allocations_total", "type=\"registra_utente\"", "Heap allocations made while handling client requests");
+        matrix_allocations = metrics_counter("paroliere_request_allocations_total", "type=\"matrice\"", "Heap allocations made while handling client requests");
+        word_allocations = metrics_counter("paroliere_request_allocations_total", "type=\"parola\"", "Heap allocations made while handling client requests");
+        other_allocations = metrics_counter("paroliere_request_allocations_total", "type=\"other\"", "Heap allocations made while handling client requests");
+    }
+    metrics_gauge("paroliere_stage_depth", "stage=\"validation_queue\"", "Word submissions in each stage of the validation pipeline", read_validation_queued);
+    metrics_gauge("paroliere_stage_depth", "stage=\"validating\"", "Word submissions in each stage of the validation pipeline", read_validation_busy);
+    metrics_gauge("paroliere_stage_depth", "stage=\"reply\"", "Word submissions in each stage of the validation pipeline", read_replies_pending);
+    validation_wait_duration = metrics_histogram("paroliere_validation_queue_wait_seconds", NULL, "Time a word waited for a validation worker");
+    metrics_read_counter("paroliere_room_events_total", NULL, "Events handled by the room thread", read_room_events);
+    dictionary_cache_hits = metrics_counter("paroliere_dictionary_cache_lookups_total", "result=\"hit\"", "Dictionary lookups by whether the verdict was cached");
+    dictionary_cache_misses = metrics_counter("paroliere_dictionary_cache_lookups_total", "result=\"miss\"", "Dictionary lookups by whether the verdict was cached");
+    metrics_gauge("paroliere_dictionary_cache_entries", NULL, "Words with a cached dictionary verdict", read_dictionary_cache_entries);
+    metrics_read_counter("paroliere_dictionary_cache_evictions_total", NULL, "Cached dictionary verdicts replaced by another word", read_dictionary_cache_evictions);
+    slow_clients_disconnected = metrics_counter("paroliere_slow_clients_disconnected_total", NULL, "Clients disconnected for not reading their broadcasts in time");
+    transition_duration = metrics_histogram("paroliere_round_transition_duration_seconds", NULL, "Time spent in a round transition");
+    scoreboard_encode_duration = metrics_histogram("paroliere_scoreboard_encode_duration_seconds", NULL, "Time to encode the final scoreboard");
+    metrics_gauge("paroliere_round_arena_bytes", NULL, "Bytes allocated from the round arena", read_round_arena_bytes);
+    metrics_gauge("paroliere_resident_memory_kb", NULL, "Resident set size", get_rss_kb);
+    metrics_gauge("paroliere_log_records_dropped", NULL, "Log records dropped because a ring was full", read_log_records_dropped);
+}
+
+static Metric* request_duration_metric(char type) {
+    switch (type) {
+        case MSG_REGISTRA_UTENTE: return registration_duration;
+        case MSG_MATRICE: return matrix_duration;
+        case MSG_PAROLA: return word_duration;
+        default: return other_duration;
+    }
+}
+
+static Metric* request_allocations_metric(char type) {
+    switch (type) {
+        case MSG_REGISTRA_UTENTE: return registration_allocations;
+        case MSG_MATRICE: return matrix_allocations;
+        case MSG_PAROLA: return word_allocations;
+        default: return other_allocations;
+    }
+}
+
+#define ROUND_READERS_YIELDS 64 // Before wait_for_round_readers starts sleeping
+
+// The round state (phase, deadline, matrix) is published as an immutable snapshot.
+// Two slots are alternated: a transition fills the one that isn't current and swaps the pointer.
+static RoundSnapshot round_slots[2];
+static _Atomic(RoundSnapshot*) current_round = &round_slots[0];
 
 // ---- FUNCTION DECLARATIONS ----
 
-// This function is handling the alarm signal to switch the game state between waiting and playing.
-static void alarm_handler() {
-    pthread_mutex_lock(&state_mutex);
+// Current time of the round deadlines, the real monotonic clock unless simulating.
+static long long round_clock_ms() {
+    return simulated_clock ? atomic_load(&simulated_now_ms) : monotonic_ms();
+}
 
-    if (game_state == WAITING_STATE) {
-        transition_to_game_state(); // Switching to the game state.
-    } else {
-        transition_to_waiting_state(); // Switching to the waiting state.
+// Getting a reference to the current round, it stays valid until release_round is called.
+RoundSnapshot* acquire_round() {
+    while (1) {
+        RoundSnapshot* round = atomic_load(&current_round);
+        atomic_fetch_add(&round->readers, 1);
+        // Checking that the snapshot wasn't replaced between the load and the increment.
+        if (round == atomic_load(&current_round)) {
+            return round;
+        }
+        atomic_fetch_sub(&round->readers, 1);
     }
+}
 
-    pthread_mutex_unlock(&state_mutex);
+void release_round(RoundSnapshot* round) {
+    atomic_fetch_sub(&round->readers, 1);
+}
 
-    // Setting the next alarm based on the current game state.
-    alarm(game_state == WAITING_STATE ? 20 : match_duration);
+// Waiting until no thread is reading the given snapshot anymore. A reader holds it for one lookup, so a few
+// yields are usually enough; a reader that got descheduled is waited for with sleeps doubling up to 1 ms.
+static void wait_for_round_readers(RoundSnapshot* round) {
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000 };
+    for (int attempt = 0; atomic_load(&round->readers) > 0; attempt++) {
+        if (attempt < ROUND_READERS_YIELDS) {
+            sched_yield();
+            continue;
+        }
+        nanosleep(&pause, NULL);
+        if (pause.tv_nsec < 1000000) {
+            pause.tv_nsec *= 2;
+        }
+    }
+}
+
+// Getting the slot that isn't current, once all its previous readers are gone.
+static RoundSnapshot* prepare_next_round() {
+    RoundSnapshot* current = atomic_load(&current_round);
+    RoundSnapshot* next = current == &round_slots[0] ? &round_slots[1] : &round_slots[0];
+    wait_for_round_readers(next);
+    return next;
+}
+
+// Making a fully written snapshot visible to every thread, returning the previous one.
+static RoundSnapshot* publish_round(RoundSnapshot* next) {
+    return atomic_exchange(&current_round, next);
+}
+
+// Computing the seconds left before the end of the round phase, rounding up.
+static unsigned int time_left_in(const RoundSnapshot* round) {
+    long long remaining_ms = round->deadline_ms - round_clock_ms();
+    return remaining_ms > 0 ? (unsigned int)((remaining_ms + 999) / 1000) : 0;
 }
 
 // This function is retrieving the remaining time left in the current game state.
 unsigned int get_time_left() {
-    pthread_mutex_lock(&time_mutex);
-    unsigned int time_left = alarm(0); // Canceling the current alarm and getting the remaining time.
-    if (time_left > 0) {
-        alarm(time_left); // Resetting the alarm with the remaining time.
-    }
-    pthread_mutex_unlock(&time_mutex);
+    RoundSnapshot* round = acquire_round();
+    unsigned int time_left = time_left_in(round);
+    release_round(round);
     return time_left;
 }
 
@@ -77,458 +231,779 @@ int serialize_message(const Message *msg, char *buffer, size_t buffer_size) {
     return offset + msg->size;
 }
 
-// Deserializing a buffer into a Message structure to understand the client's request.
-Message* deserialize_message(const char *buffer, size_t buffer_size) {
-    if (!buffer || buffer_size < sizeof(char) + sizeof(int)) {      
-        return NULL; // Returning NULL if the buffer size is too small.
+// Parsing the frame at the start of buffer in place: msg->data points into buffer and isn't NUL terminated.
+// Returning the frame length, 0 while the frame is incomplete, -1 if it can never be valid.
+int deserialize_message(const char *buffer, size_t buffer_size, Message *msg) {
+    int header_size = sizeof(char) + sizeof(int);
+    if (!buffer || buffer_size < (size_t)header_size) {
+        return 0; // Waiting for the rest of the header.
     }
 
-    Message *msg = malloc(sizeof(Message));
-    if (!msg) {
-        return NULL;  // Returning NULL if memory allocation failed.
+    msg->type = buffer[0]; // Reading the message type.
+    memcpy(&msg->size, buffer + sizeof(char), sizeof(int)); // Reading the message size.
+    if (msg->size < 0 || msg->size > MAX_BUFFER_SIZE - header_size) {
+        return -1; // A frame that wouldn't fit in a connection buffer.
     }
-
-    int offset = 0;
-    msg->type = buffer[offset++]; // Reading the message type.
-    memcpy(&msg->size, buffer + offset, sizeof(int)); // Reading the message size.
-    offset += sizeof(int);
-
-    if ((int)buffer_size < offset + msg->size) {
-        free(msg);
-        return NULL;  // Returning NULL if the buffer is smaller than expected.
+    if (buffer_size < (size_t)(header_size + msg->size)) {
+        return 0; // Waiting for the rest of the payload.
     }
-
-    msg->data = malloc(msg->size + 1);
-    if (!msg->data) {
-        free(msg);
-        return NULL;  // Returning NULL if memory allocation failed.
+    msg->data = (char *)buffer + header_size;
+
+    // Logging the parsed message with a hex dump, only built when debug output is on.
+    if (log_enabled(LOG_LEVEL_DEBUG)) {
+        char hex[LOG_MESSAGE_SIZE];
+        int hex_length = 0;
+        for (int i = 0; i < msg->size && hex_length < (int)sizeof(hex) - 3; i++) {
+            hex_length += snprintf(hex + hex_length, sizeof(hex) - hex_length, "%02x ", (unsigned char)msg->data[i]);
+        }
+        hex[hex_length] = '\0';
+        LOG_DEBUG("Message received -> type: %c size: %d data: %.*s [%s]", msg->type, msg->size, msg->size, msg->data, hex);
     }
 
-    memcpy(msg->data, buffer + offset, msg->size); // Reading the message data.
-    msg->data[msg->size] = '\0';
-
-    // Printing parsed message for debugging purposes.
-    printf("Message received -> type: %c size: %d data: %s\n", msg->type, msg->size, msg->data);
-    for (int i = 0; i < msg->size; i++) printf("%02x ", (unsigned char)msg->data[i]);
-    printf("\n\n");
+    return header_size + msg->size;
+}
 
-    return msg;
+// Closing a frame: writing its length prefix, type and payload size in front of the payload.
+static void close_frame(char *frame, char type, int payload_size) {
+    int msg_size = sizeof(char) + sizeof(int) + payload_size;
+    memcpy(frame, &msg_size, sizeof(int));
+    frame[sizeof(int)] = type;
+    memcpy(frame + sizeof(int) + sizeof(char), &payload_size, sizeof(int));
 }
 
-// Sending a serialized message to a client.
-void send_message_to_client(const Message *msg, int client_fd) {
-    char buffer[MAX_BUFFER_SIZE];
-    
-    // Serializing the message and getting the size.
-    int msg_size = serialize_message(msg, buffer + sizeof(int), MAX_BUFFER_SIZE - sizeof(int));
-    if (msg_size < 0) {
-        fprintf(stderr, "Error during message serialization\n");
-        return;
-    }
+// Encoding a whole frame at frame, returning its size.
+static size_t encode_frame(char *frame, char type, const char *payload, int payload_size) {
+    memcpy(frame + FRAME_HEADER_SIZE, payload, payload_size);
+    close_frame(frame, type, payload_size);
+    return FRAME_HEADER_SIZE + payload_size;
+}
 
-    // Prepending the message size to the buffer.
-    int total_size = msg_size + sizeof(int);
-    memcpy(buffer, &msg_size, sizeof(int));
+// Replies are encoded by the connection's own thread straight into the player's output buffer and written from there.
+// Broadcasts are written by the sender thread and the leaderboard push, the send lock keeps their frames apart from the replies.
+static char* reply_payload(Player *player) {
+    return player->output + FRAME_HEADER_SIZE;
+}
 
-    int bytes;
-    printf("Sending message to client %d\n", client_fd);
-    printf("Message size: %d\n", msg_size);
-    printf("Message data: %s\n", msg->data);
-    printf("Message type: %c\n", msg->type);
-    SYSC(bytes, write(client_fd, buffer, total_size), "Error during message sending");
+static void send_reply(Player *player, char type, int payload_size) {
+    close_frame(player->output, type, payload_size);
+    LOG_DEBUG("Sending message to client %d -> type: %c size: %d data: %.*s", player->fd, type, payload_size, payload_size, reply_payload(player));
+    pthread_mutex_lock(&player->send_lock);
+    if (!write_all(player->fd, player->output, FRAME_HEADER_SIZE + payload_size)) {
+        LOG_WARN("Error during message sending to client %d: %s", player->fd, strerror(errno));
+    }
+    pthread_mutex_unlock(&player->send_lock);
 }
 
-// Sending the game matrix to a client.
-void send_matrix_to_client(int client_fd) {
-    Message response;
+static void send_text_reply(Player *player, char type, const char *text) {
+    int length = strlen(text);
+    memcpy(reply_payload(player), text, length);
+    send_reply(player, type, length);
+}
 
-    Player* player_searched = find_player(players_array, client_fd);
+// Sending the game matrix to a client, copied into the reply so the round isn't held during the write.
+void send_matrix_to_client(Player *player) {
+    if (!atomic_load(&player->is_registered)) {
+        send_text_reply(player, MSG_ERR, "You're not registered yet\n");
+        return;
+    }
 
-    if (game_state == GAME_STATE && player_searched != NULL) {
-        Message response = {
-            .type = MSG_MATRICE,
-            .data = (char *)matrix,
-            .size = sizeof(matrix)
-        };
+    RoundSnapshot* round = acquire_round();
+    GameState state = round->state;
+    memcpy(reply_payload(player), round->matrix, sizeof(round->matrix));
+    release_round(round);
 
-        send_message_to_client(&response, client_fd);
-    } else if (player_searched == NULL) {
-        response.type = MSG_ERR;
-        strcpy(response.data, "You're not registered yet\n");
-        response.size = strlen(response.data);
-        send_message_to_client(&response, client_fd);
+    if (state == GAME_STATE) {
+        send_reply(player, MSG_MATRICE, MATRIX_BYTES);
     } else {
-        response.type = MSG_ERR;
-        strcpy(response.data, "Game hasn't started yet\n");
-        response.size = strlen(response.data);
-        send_message_to_client(&response, client_fd);
+        send_text_reply(player, MSG_ERR, "Game hasn't started yet\n");
     }
 }
 
-// Sending the remaining time to a client.
-void send_time_left_to_client(int client_fd) {
-    char time_left_string[20];
-    sprintf(time_left_string, "%d", get_time_left());
+// Writing the remaining time as text into payload, returning its length and the type of message for the phase.
+static int encode_time_left(char *payload, char *type) {
+    RoundSnapshot* round = acquire_round();
+    *type = round->state == GAME_STATE ? MSG_TEMPO_PARTITA : MSG_TEMPO_ATTESA;
+    unsigned int time_left = time_left_in(round);
+    release_round(round);
 
-    Message response = {
-        .type = game_state == GAME_STATE ? MSG_TEMPO_PARTITA : MSG_TEMPO_ATTESA,
-        .data = strdup(time_left_string),
-        .size = strlen(time_left_string)
-    };
+    return sprintf(payload, "%u", time_left);
+}
 
-    send_message_to_client(&response, client_fd);
-    free(response.data);
+// Replying with the remaining time from the player's own thread.
+static void send_time_left_reply(Player *player) {
+    char type;
+    int size = encode_time_left(reply_payload(player), &type);
+    send_reply(player, type, size);
 }
 
-// Sending the remaining time to all clients.
-void send_time_left_to_all(PlayerArray *players_array) {
+// Handing the same frames for every registered player to the sender thread, which writes the sockets.
+// The room only copies the frames and retains the players: a client that stops reading never holds up its events.
+// Room thread only, the players can't be freed meanwhile since only the room removes them.
+static void broadcast_to_players(const char *frames, size_t size) {
+    BroadcastBatch *batch = broadcast_batch(broadcast_sender, frames, size);
+    pthread_rwlock_rdlock(&players_array->lock);
     for (int i = 0; i < players_array->size; i++) {
-        send_time_left_to_client(players_array->players[i].fd);
+        broadcast_batch_add(batch, players_array->players[i]);
     }
+    pthread_rwlock_unlock(&players_array->lock);
+    broadcast_post(broadcast_sender, batch);
 }
 
-// Helper thread loop for each player to handle game-related tasks.
-void *player_helper_thread_loop(void *player_arg) {
-    Player *player = (Player *)player_arg;
+// Sending the matrix of a freshly published round and its time left to all players, as one write each.
+static void send_round_start_to_all(RoundSnapshot *round) {
+    char frames[2 * MAX_BUFFER_SIZE];
+    size_t size = encode_frame(frames, MSG_MATRICE, (const char *)round->matrix, sizeof(round->matrix));
 
-    while (1) {
-        pthread_mutex_lock(&state_mutex);
+    char type;
+    int time_size = encode_time_left(frames + size + FRAME_HEADER_SIZE, &type);
+    close_frame(frames + size, type, time_size);
+    size += FRAME_HEADER_SIZE + time_size;
 
-        // Waiting until the game ends.
-        while (!is_game_ended) {
-            printf("Player %s is waiting for game to end\n", player->username);
-            pthread_cond_wait(&game_over_condition, &state_mutex);
-        }
+    broadcast_to_players(frames, size);
+}
 
-        // Handling player disconnection.
-        if (player->fd < 0) {
-            free(player->words);
-            free(player);
+// Sending the remaining time to all clients.
+static void send_time_left_to_all() {
+    char frame[MAX_BUFFER_SIZE];
+    char type;
+    int size = encode_time_left(frame + FRAME_HEADER_SIZE, &type);
+    close_frame(frame, type, size);
 
-            pthread_mutex_unlock(&state_mutex);
-            pthread_exit(NULL);
-        }
+    broadcast_to_players(frame, FRAME_HEADER_SIZE + size);
+}
 
-        // Adding player's score to the scores list.
-        add_player_score(scores_list, player->username, player->score);
-        printf("Player %s has scored %d points\n", player->username, player->score);
+// Posting a request to the room and waiting until it has been handled.
+static void room_request(RoomEventType type, RoomRequest *request) {
+    sem_init(&request->done, 0, 0);
+    room_post(room, type, request);
+    while (sem_wait(&request->done) == -1 && errno == EINTR);
+    sem_destroy(&request->done);
+}
 
-        // Signaling the scores list condition if all players have finished.
-        if (scores_list->size == players_array->size) {
-            is_scores_list_ready = 1;
-            pthread_cond_signal(&scores_list_condition);
-        }
+// Handling player registration, the player joins the room on its thread and the replies are sent from here.
+void handle_registration(Player *player, char *username) {
+    RoomRequest request = { .player = player, .username = username };
+    room_request(ROOM_JOIN, &request);
 
-        // Waiting until the CSV results are ready.
-        while (!is_csv_results_scoreboard_ready) {
-            pthread_cond_wait(&csv_results_condition, &state_mutex);
-        }
+    if (request.result.code != SUCCESS.code) {
+        send_text_reply(player, MSG_ERR, request.result.message);
+        return;
+    }
 
-        // Sending the final scores to the player.
-        Message response = {
-            .type = MSG_PUNTI_FINALI,
-            .data = strdup(csv_result),
-            .size = strlen(csv_result)
-        };
+    if (get_game_state() == GAME_STATE) {
+        send_matrix_to_client(player);
+    }
 
-        send_message_to_client(&response, player->fd);
-        free(response.data);
+    send_time_left_reply(player);
+    send_text_reply(player, MSG_OK, "Registration successful");
+}
 
-        pthread_mutex_unlock(&state_mutex);
+// Looking the lowercase word up in the verdict cache first, the trie is only walked for words not cached.
+// Both answers are cached: invalid words are submitted again as often as valid ones.
+static bool is_word_in_dictionary_cached(char *word) {
+    bool in_dictionary;
+    if (verdict_cache_lookup(dictionary_cache, word, &in_dictionary)) {
+        metric_add(dictionary_cache_hits, 1);
+        return in_dictionary;
     }
-
-    return NULL;
+    metric_add(dictionary_cache_misses, 1);
+    in_dictionary = is_word_in_dictionary(dictionary_root, word);
+    verdict_cache_insert(dictionary_cache, word, in_dictionary);
+    return in_dictionary;
 }
 
-// Handling player registration.
-void handle_registration(Player *player, char *username) {
-    Message response;
-    response.data = (char*)malloc(1024);
+// Validating a submitted word on a pool worker, against the matrix and the dictionary only:
+// a word that passes is forwarded to the room, which scores it. Rejections are answered right away.
+// The word is lowercased and validated where it was received and the reply is encoded in the output buffer,
+// nothing is allocated. The connection thread is waiting meanwhile, so both buffers are ours.
+static bool validate_word(ValidationJob *job) {
+    Player *player = job->player;
+    char *word = job->word;
+    Message response = { .data = reply_payload(player) };
+    long points = -1; // What the flight recorder sees: -1 for a rejected word
 
-    Player *player_searched = find_player(players_array, player->fd);
-    if (player_searched != NULL) {
-        response.type = MSG_ERR;
-        strcpy(response.data, "Player already registered");
-    } else if (is_username_taken(players_array, username)) {
+    LOG_DEBUG("Player with username %s submitted word %s", player->username, word);
+
+    for (int i = 0; word[i]; i++) {
+        word[i] = tolower(word[i]);
+    }
+
+    if (!atomic_load(&player->is_registered)) {
+        metric_add(words_rejected, 1);
         response.type = MSG_ERR;
-        strcpy(response.data, "Invalid username");
+        strcpy(response.data, "You're not registered yet");
     } else {
-        response.type = MSG_OK;
-        strcpy(response.data, "Registration successful");
-        Player *new_player = add_player(players_array, player->fd, pthread_self(), username);
-
-        if (new_player == NULL) {
+        // Holding the round only while reading its matrix, the room checks the iteration again when scoring.
+        RoundSnapshot* round = acquire_round();
+        GameState state = round->state;
+        bool valid = state == GAME_STATE && is_word_in_matrix(round->matrix, word) && is_word_in_dictionary_cached(word);
+        job->iteration = round->iteration;
+        release_round(round);
+
+        if (state == WAITING_STATE) {
+            metric_add(words_rejected, 1);
             response.type = MSG_ERR;
-            response.size = strlen("Failed to register player: lobby is full :(\n");
-            response.data = (char*)malloc(response.size);
-            strcpy(response.data, "Failed to register player: lobby is full :(\n");
-            send_message_to_client(&response, player->fd);
-            return;
-        }
-
-        if (game_state == GAME_STATE) {
-            send_matrix_to_client(player->fd);
+            strcpy(response.data, "Waiting for match to start");
+        } else if (!valid) {
+            metric_add(words_invalid, 1);
+            response.type = MSG_ERR;
+            strcpy(response.data, "Invalid word");
+        } else {
+            return false;
         }
-
-        send_time_left_to_client(player->fd);
-
-        // Creating a helper thread for the player.
-        pthread_create(&new_player->scorer_tid, NULL, player_helper_thread_loop, new_player);
     }
+    flight_record(FLIGHT_VALIDATION_DONE, player->connection_id, points);
 
-    response.size = strlen(response.data);
-    send_message_to_client(&response, player->fd);
-    free(response.data);
+    job->reply_type = response.type;
+    job->reply_size = strlen(response.data);
+    job->points = points;
+    return true;
 }
 
-// Handling word submission by players.
-void handle_word_submission(Player *player, const char *word) {
-    Message response;
-    response.data = malloc(MAX_MESSAGE_DATA_SIZE);
-    
-    printf("Player with username %s submitted word %s\n", player->username, word);
-
-    char *word_lowercase = strdup(word);
-    for (int i = 0; word_lowercase[i]; i++) {
-        word_lowercase[i] = tolower(word_lowercase[i]);
-    }
-
-    Player *player_searched = find_player(players_array, player->fd);
+static void forward_to_room(ValidationJob *job) {
+    room_post(room, ROOM_WORD, job);
+}
 
-    if (player_searched == NULL) {
-        response.type = MSG_ERR;
-        strcpy(response.data, "You're not registered yet");
-    } else if (game_state == WAITING_STATE) {
+// Scoring a valid word on the room thread, the only one touching the players' words and scores.
+static void score_word(ValidationJob *job) {
+    long allocations_start = thread_allocations();
+    Player *player = job->player;
+    char *word = job->word;
+    Message response = { .data = reply_payload(player) };
+    long points = -1;
+    RoundSnapshot *round = atomic_load(&current_round); // Only replaced by this thread
+
+    if (round->state != GAME_STATE || round->iteration != job->iteration) {
+        // The round the word was validated against ended meanwhile.
+        metric_add(words_rejected, 1);
         response.type = MSG_ERR;
         strcpy(response.data, "Waiting for match to start");
-    } else if (!is_word_in_matrix(matrix, word_lowercase) || !is_word_in_dictionary(dictionary_root, word_lowercase)) {
-        response.type = MSG_ERR;
-        strcpy(response.data, "Invalid word");
-    } else if (has_player_used_word(player_searched, word_lowercase)) {
+    } else if (!add_word_if_new(round_arena, player, word)) {
+        metric_add(words_duplicate, 1);
+        points = 0;
         response.type = MSG_PUNTI_PAROLA;
         strcpy(response.data, "0");
     } else {
+        metric_add(words_valid, 1);
         response.type = MSG_PUNTI_PAROLA;
-        int points_gained = strlen(word_lowercase);
-        update_player_score(player_searched, points_gained);
-        add_word_to_player(player_searched, word_lowercase);
+        int points_gained = strlen(word);
+        points = points_gained;
+        update_player_score(player, points_gained);
+        leaderboard_update(leaderboard, player, atomic_load(&player->score));
         sprintf(response.data, "%d", points_gained);
     }
+    flight_record(FLIGHT_VALIDATION_DONE, player->connection_id, points);
+
+    job->reply_type = response.type;
+    job->reply_size = strlen(response.data);
+    job->points = points;
+    job->allocations += thread_allocations() - allocations_start;
+    validation_job_done(validation_pool, job);
+}
 
-    response.size = strlen(response.data);
-    send_message_to_client(&response, player->fd);
-    free(response.data);
-    free(word_lowercase);
+// Handling word submission by players: the word goes through the validation pool
+// and the reply it encoded is written from this thread, so workers never block on a socket.
+void handle_word_submission(Player *player, char *word) {
+    PROBE2(word__start, player->connection_id, word);
+    ValidationJob job = { .player = player, .word = word };
+    validation_pool_run(validation_pool, &job);
+    thread_allocations_add(job.allocations);
+    histogram_record(validation_wait_duration, job.started_ns - job.enqueued_ns);
+
+    send_reply(player, job.reply_type, job.reply_size);
+    validation_reply_sent(validation_pool);
+    PROBE2(word__end, player->connection_id, job.points);
+}
+
+// Handling one request, msg->data is a view into the connection buffer.
+static void handle_message(Player *player, Message *msg, long long start_ns) {
+    long allocations_start = thread_allocations();
+    // The payload is followed by the next frame or by the spare byte of the buffer,
+    // that byte is swapped for a terminator while the handlers use the payload as a string.
+    char following = msg->data[msg->size];
+    msg->data[msg->size] = '\0';
+    flight_record(FLIGHT_MESSAGE_RECEIVED, player->connection_id, msg->type);
+    PROBE3(message__receive, player->connection_id, msg->type, msg->size);
+
+    switch (msg->type) {
+        case MSG_REGISTRA_UTENTE:
+            handle_registration(player, msg->data);
+            break;
+        case MSG_MATRICE:
+            send_matrix_to_client(player);
+            send_time_left_reply(player);
+            break;
+        case MSG_PAROLA:
+            handle_word_submission(player, msg->data);
+            break;
+        default:
+            LOG_WARN("Unknown message type from client %d", player->fd);
+            break;
+    }
+
+    flight_record(FLIGHT_RESPONSE_WRITTEN, player->connection_id, msg->type);
+    PROBE2(message__dispatched, player->connection_id, msg->type);
+    histogram_record(request_duration_metric(msg->type), monotonic_ns() - start_ns);
+    if (ALLOCATION_COUNTING) {
+        metric_add(request_allocations_metric(msg->type), thread_allocations() - allocations_start);
+    }
+    msg->data[msg->size] = following;
 }
 
 // Main player handler function.
+// A read can hold several frames or end in the middle of one, every complete frame is handled
+// in place and an incomplete one is moved to the front of the buffer to be completed by the next read.
 void* handle_player(void* player_arg) {
     Player *player = (Player *)player_arg;
-    char* buffer = (char*)malloc(MAX_BUFFER_SIZE);
+    char* buffer = (char*)malloc(MAX_BUFFER_SIZE + 1); // Spare byte to terminate a payload ending the buffer
+    size_t buffered = 0;
+    bool malformed = false;
     int bytes_read;
     
-    while ((bytes_read = read(player->fd, buffer, MAX_BUFFER_SIZE)) > 0) {
-        Message *msg = deserialize_message(buffer, bytes_read);
-        if (!msg) {
-            fprintf(stderr, "Error deserializing message from client");
-            continue;
-        }
-
-        switch (msg->type) {
-            case MSG_REGISTRA_UTENTE:
-                handle_registration(player, msg->data);
-                break;
-            case MSG_MATRICE:
-                send_matrix_to_client(player->fd);
-                send_time_left_to_client(player->fd);
-                break;
-            case MSG_PAROLA:
-                handle_word_submission(player, msg->data);
-                break;
-            default:
-                fprintf(stderr, "Unknown message type from client %d\n", player->fd);
+    while (!malformed && (bytes_read = read(player->fd, buffer + buffered, MAX_BUFFER_SIZE - buffered)) > 0) {
+        buffered += bytes_read;
+        size_t offset = 0;
+
+        while (1) {
+            long long start_ns = monotonic_ns();
+            Message msg;
+            int frame_size = deserialize_message(buffer + offset, buffered - offset, &msg);
+            if (frame_size <= 0) {
+                malformed = frame_size < 0;
                 break;
+            }
+            handle_message(player, &msg, start_ns);
+            offset += frame_size;
         }
 
-        free(msg->data);
-        free(msg);
+        memmove(buffer, buffer + offset, buffered - offset);
+        buffered -= offset;
     }
 
-    printf("Client disconnected\n");
-    remove_player(players_array, player->fd);
-    close(player->fd);
+    if (malformed) {
+        LOG_WARN("Malformed message from client %d, closing the connection", player->fd);
+    }
+    LOG_DEBUG("Client %d disconnected", player->fd);
+    metric_add(clients_connected, -1);
+    flight_record(FLIGHT_DISCONNECT, player->connection_id, player->fd);
+    // Once out of the room no other thread can reach the player, it's freed with the last broadcast writing to it.
+    RoomRequest request = { .player = player };
+    room_request(ROOM_LEAVE, &request);
+    free(buffer);
+    release_player(player);
     pthread_exit(NULL);
 }
 
-// Resetting game variables for a new round.
-static void reset_game_variables() {
-    is_game_ended = false;
-    is_scores_list_ready = false;
-    is_csv_results_scoreboard_ready = false;
+GameState get_game_state() {
+    RoundSnapshot* round = acquire_round();
+    GameState state = round->state;
+    release_round(round);
+    return state;
 }
 
-// Freeing the scores list memory.
+// Dropping the scores list, its memory is released with the round arena.
 static void free_scores_list() {
-    if (scores_list) {
-        free_player_score_list(scores_list);
-        scores_list = NULL;
-    }
+    scores_list = NULL;
+    final_scoreboard = (EncodedScoreboard){0};
 }
 
 // Transitioning the game to the active state.
 static void transition_to_game_state() {
-    game_state = GAME_STATE;
-    printf("\n" BOLD RED "GAME IS ON!!\n\n" RESET);
+    // The free slot held the previous game, its last submissions are over once we get it.
+    RoundSnapshot* next = prepare_next_round();
+    LOG_INFO(BOLD RED "GAME IS ON!!" RESET);
 
-    // Resetting player scores and words for a new game.
+    // Releasing all the data of the previous round in one go, then resetting player scores and words.
+    free_scores_list();
+    arena_reset(round_arena);
+    pthread_rwlock_rdlock(&players_array->lock);
     for (int i = 0; i < players_array->size; i++) {
-        players_array->players[i].score = 0;
-        players_array->players[i].word_size = 0;
-        players_array->players[i].words = malloc(INITIAL_WORD_CAPACITY * sizeof(char*));
+        reset_player_round(players_array->players[i]);
     }
+    pthread_rwlock_unlock(&players_array->lock);
+    leaderboard_reset(leaderboard);
 
     // Generating a new matrix for the game.
-    matrix_file_global ? init_matrix_from_file(matrix, matrix_file_global, game_iteration) : init_matrix_random(matrix);
-    send_matrix_to_all(players_array, matrix);
-    send_time_left_to_all(players_array);
-    reset_game_variables();
-    free_scores_list();
+    matrix_file_global ? init_matrix_from_file(next->matrix, matrix_file_global, game_iteration) : init_matrix_random(next->matrix);
+    next->state = GAME_STATE;
+    next->iteration = game_iteration;
+    next->deadline_ms = round_clock_ms() + match_duration * 1000LL;
+    publish_round(next);
+    flight_record(FLIGHT_ROUND_PUBLISHED, NO_CONNECTION, game_iteration);
+
+    send_round_start_to_all(next);
 }
 
-// Initializing the scores list for the new game.
-static void initialize_scores_list() {
-    scores_list = create_player_score_list(players_array->size);
+// Encoding the sorted scores once as "username,score,..." split into as many frames as needed.
+// Frames are cut between entries, every frame but the last is MSG_PUNTI_FINALI_PARZIALI.
+// The whole scoreboard is a single buffer that is written as is to every player.
+static EncodedScoreboard encode_scoreboard(ScoresList *list) {
+    // Upper bound: every entry at its longest, plus a frame header each time a frame can fill up.
+    size_t max_entry_length = MAX_USERNAME_LENGTH + MAX_SCORE_DIGITS + 1;
+    size_t max_payload = list->size * max_entry_length;
+    size_t max_frames = max_payload / (MAX_FRAME_DATA_SIZE - max_entry_length) + 1;
+    char *buffer = arena_alloc(round_arena, max_payload + max_frames * FRAME_HEADER_SIZE);
+
+    EncodedScoreboard scoreboard = { .data = buffer, .size = 0, .frames = 0, .players = list->size };
+    char *frame = buffer;
+    int payload_size = 0;
+    char entry[MAX_USERNAME_LENGTH + MAX_SCORE_DIGITS + 1];
+
+    for (int i = 0; i < list->size; i++) {
+        int entry_length = snprintf(entry, sizeof(entry), "%s,%d", list->players[i].username, list->players[i].score);
+        int separator = payload_size > 0 ? 1 : 0;
+
+        // Starting a new frame when this entry wouldn't fit in the current one.
+        if (payload_size + separator + entry_length > (int)MAX_FRAME_DATA_SIZE) {
+            close_frame(frame, MSG_PUNTI_FINALI_PARZIALI, payload_size);
+            frame += FRAME_HEADER_SIZE + payload_size;
+            scoreboard.frames++;
+            payload_size = 0;
+            separator = 0;
+        }
+
+        char *payload = frame + FRAME_HEADER_SIZE;
+        if (separator) {
+            payload[payload_size++] = ',';
+        }
+        memcpy(payload + payload_size, entry, entry_length);
+        payload_size += entry_length;
+    }
+
+    close_frame(frame, MSG_PUNTI_FINALI, payload_size);
+    frame += FRAME_HEADER_SIZE + payload_size;
+    scoreboard.frames++;
+    scoreboard.size = frame - buffer;
+
+    return scoreboard;
 }
 
-// Notifying threads to send final results.
-static void trigger_send_final_results() {
-    is_game_ended = true;
-    pthread_cond_broadcast(&game_over_condition);
+// The single end-of-round aggregator: snapshotting every score, sorting once,
+// encoding the scoreboard once and sending the same bytes to every player.
+static void publish_final_scores() {
+    scores_list = snapshot_player_scores(players_array, round_arena);
+
+    // Sorting scores in descending order.
+    qsort(scores_list->players, scores_list->size, sizeof(PlayerScore), sort_helper_players);
+
+    // Encoding the final scores, timing it since it grows with the room.
+    long long encode_start_ns = monotonic_ns();
+    final_scoreboard = encode_scoreboard(scores_list);
+    long long encode_ns = monotonic_ns() - encode_start_ns;
+    histogram_record(scoreboard_encode_duration, encode_ns);
+    flight_record(FLIGHT_SCOREBOARD_ENCODED, NO_CONNECTION, final_scoreboard.players);
+    LOG_INFO("Final scoreboard: %d players, %zu bytes in %d frames, encoded in %lld us",
+           final_scoreboard.players, final_scoreboard.size, final_scoreboard.frames, encode_ns / 1000);
+
+    broadcast_to_players(final_scoreboard.data, final_scoreboard.size);
 }
 
 // Transitioning the game to the waiting state.
 static void transition_to_waiting_state() {
-    game_state = WAITING_STATE;
-    printf("\n" BOLD BLUE "TIME FOR A BREAK! SEE YOU IN 1 MIN\n\n" RESET);
-
-    if (players_array != NULL && players_array->size > 0) {
-        initialize_scores_list();
-        trigger_send_final_results();
-        send_time_left_to_all(players_array);
+    RoundSnapshot* next = prepare_next_round();
+    LOG_INFO(BOLD BLUE "TIME FOR A BREAK! SEE YOU IN 1 MIN" RESET);
+
+    next->state = WAITING_STATE;
+    next->iteration = game_iteration;
+    next->deadline_ms = round_clock_ms() + waiting_duration * 1000LL;
+    RoundSnapshot* finished_round = publish_round(next);
+    flight_record(FLIGHT_ROUND_PUBLISHED, NO_CONNECTION, game_iteration);
+
+    // Letting the submissions still running on the finished round complete before scoring.
+    wait_for_round_readers(finished_round);
+    flight_record(FLIGHT_READERS_DRAINED, NO_CONNECTION, game_iteration);
+
+    if (players_array->size > 0) {
+        publish_final_scores();
+        send_time_left_to_all();
+        flight_record(FLIGHT_SCOREBOARD_SENT, NO_CONNECTION, game_iteration);
     }
 
+    LOG_INFO("Round %d ended - round arena: %zu/%zu bytes, RSS: %ld KB, log records dropped: %ld",
+             game_iteration, arena_bytes_used(round_arena), arena_bytes_reserved(round_arena), get_rss_kb(), log_dropped());
+
+    metric_add(rounds_total, 1);
     game_iteration++;
 }
 
-// Loading configuration from a file.
-Error load_config(const char *filename, Config *config) {
-    FILE *file;
-    SYSCN(file, fopen(filename, "r"), "Failed to open config file");
+// State kept by the push thread between leaderboard pushes.
+typedef struct {
+    char *frames; // Every frame of one push, back to back
+    size_t frames_capacity;
+    Broadcast broadcast;
+} LeaderboardPush;
+
+// Sending the top K and their own rank to every player whose view changed since the last push.
+// Frames are encoded under the leaderboard mutex and written once it's released. A player still in the board
+// hasn't left the room, so its connection thread still holds it: retaining it there keeps it alive for the send.
+static void push_leaderboard(unsigned long *pushed_version, LeaderboardPush *push) {
+    pthread_mutex_lock(&leaderboard->mutex);
+
+    bool top_changed = leaderboard->top_version != *pushed_version;
+    *pushed_version = leaderboard->top_version;
+    int total = leaderboard->size;
+
+    // Encoding the shared top K part once, then prefixing each player's rank. Only whole entries are listed,
+    // as many as leave room for the longest prefix: the payload always fits one frame.
+    char top_csv[MAX_FRAME_DATA_SIZE];
+    int top_length = 0;
+    int listed = 0;
+    for (int slot = leaderboard_first(leaderboard); slot >= 0 && listed < leaderboard->top_k;
+         slot = leaderboard_next(leaderboard, slot), listed++) {
+        LeaderboardEntry *entry = &leaderboard->entries[slot];
+        char entry_text[LEADERBOARD_ENTRY_LENGTH + 1];
+        int entry_length = snprintf(entry_text, sizeof(entry_text), ",%s,%d", entry->player->username, entry->score);
+        if (top_length + entry_length > (int)(MAX_FRAME_DATA_SIZE - LEADERBOARD_PREFIX_LENGTH)) {
+            break;
+        }
+        memcpy(top_csv + top_length, entry_text, entry_length);
+        top_length += entry_length;
+    }
 
-    char line[MAX_CONF_LINE_LENGTH];
-    while (fgets(line, sizeof(line), file)) {
-        trim_newline(line);
-        char *key = strtok(line, "=");
-        char *value = strtok(NULL, "=");
+    size_t frame_capacity = FRAME_HEADER_SIZE + LEADERBOARD_PREFIX_LENGTH + top_length + 1; // And snprintf's terminator
+    if (push->frames_capacity < total * frame_capacity) {
+        push->frames_capacity = total * frame_capacity;
+        push->frames = realloc(push->frames, push->frames_capacity);
+        if (!push->frames) {
+            handle_error(MEMORY_ALLOCATION_ERROR);
+        }
+    }
 
-        if (strcmp(key, "socket_backlog") == 0) {
-            if (value != NULL && strlen(value) > 0 && value[0] != '-')
-                config->backlog = atoi(value);
-            else {
-                fclose(file);
-                return CONFIG_ERROR_BACKLOG;
-            }
+    size_t used = 0;
+    int rank = 1;
+    for (int slot = leaderboard_first(leaderboard); slot >= 0; slot = leaderboard_next(leaderboard, slot), rank++) {
+        Player *player = leaderboard->entries[slot].player;
+        if (top_changed || player->last_pushed_rank != rank) {
+            player->last_pushed_rank = rank;
+            char *frame = push->frames + used;
+            int length = snprintf(frame + FRAME_HEADER_SIZE, frame_capacity - FRAME_HEADER_SIZE, "%d,%d%.*s", rank, total, top_length, top_csv);
+            close_frame(frame, MSG_CLASSIFICA, length);
+            broadcast_add(&push->broadcast, player, frame, FRAME_HEADER_SIZE + length);
+            used += FRAME_HEADER_SIZE + length;
         }
     }
 
-    fclose(file);
-    return SUCCESS;
+    pthread_mutex_unlock(&leaderboard->mutex);
+    metric_add(slow_clients_disconnected, broadcast_send(&push->broadcast));
 }
 
-// Looping for the scorer thread to handle final scoring.
-void* scorer_thread_loop() {
-    int ret;
+// Pushing live standings at the configured rate while a game is running.
+static void* leaderboard_push_loop() {
+    unsigned long pushed_version = 0;
+    LeaderboardPush push = {0};
 
     while (1) {
-        ret = pthread_mutex_lock(&state_mutex); // Locking mutex because of players_array.
-        if (ret != 0) {
-            fprintf(stderr, "Failed to lock mutex: %s\n", strerror(ret));
-            continue;
+        sleep_until_ms(monotonic_ms() + config.leaderboard_push_ms);
+        if (get_game_state() == GAME_STATE) {
+            push_leaderboard(&pushed_version, &push);
         }
+    }
 
-        while (!is_scores_list_ready) {
-            ret = pthread_cond_wait(&scores_list_condition, &state_mutex);
-            if (ret != 0) {
-                fprintf(stderr, "Condition wait failed: %s\n", strerror(ret));
-                pthread_mutex_unlock(&state_mutex);
-                continue;
-            }
-        }
+    return NULL;
+}
 
-        is_game_ended = 0;
-        is_scores_list_ready = 0;
+// Running the transition out of the given phase, on the room thread.
+static void run_round_transition(GameState state) {
+    long long transition_start_ns = monotonic_ns();
+    int iteration = game_iteration;
+    flight_record(FLIGHT_TRANSITION_START, NO_CONNECTION, iteration);
+    GameState next_state = state == WAITING_STATE ? GAME_STATE : WAITING_STATE;
+    PROBE2(round__transition__start, iteration, next_state);
+    if (state == WAITING_STATE) {
+        transition_to_game_state(); // Switching to the game state.
+    } else {
+        transition_to_waiting_state(); // Switching to the waiting state.
+    }
+    flight_record(FLIGHT_TRANSITION_END, NO_CONNECTION, iteration);
+    PROBE2(round__transition__end, iteration, next_state);
+    histogram_record(transition_duration, monotonic_ns() - transition_start_ns);
+}
+
+// The room ticks at the end of every phase, the virtual clock of a simulation only moves with advance_round.
+static long long next_round_tick_ms() {
+    return simulated_clock ? -1 : atomic_load(&current_round)->deadline_ms;
+}
 
-        // Sorting scores in descending order.
-        qsort(scores_list->players, scores_list->size, sizeof(Player), sort_helper_players);
+static void round_tick() {
+    run_round_transition(atomic_load(&current_round)->state);
+}
 
-        // Building the CSV message with final scores.
-        int remaining_space = MAX_CSV_LENGTH;
-        char* csv_ptr = csv_result;
-        csv_result[0] = '\0';
+// Handling the events posted to the room, one at a time: nothing here needs a lock against the other events.
+// The registry and the leaderboard are still locked when written, for the threads that read them.
+static void handle_room_event(RoomEvent *event) {
+    if (event->type == ROOM_WORD) {
+        score_word((ValidationJob *)event->data);
+        return;
+    }
 
-        for (int i = 0; i < scores_list->size && remaining_space > 1; i++) {
-            int written = snprintf(csv_ptr, remaining_space, "%s,%d,", 
-                                   scores_list->players[i].username, 
-                                   scores_list->players[i].score);
-            
-            if (written >= remaining_space) {
-                // Truncating if we've run out of space.
-                break;
+    RoomRequest *request = (RoomRequest *)event->data;
+    switch (event->type) {
+        case ROOM_JOIN:
+            request->result = add_player(players_array, request->player, request->username);
+            if (request->result.code == SUCCESS.code) {
+                leaderboard_add(leaderboard, request->player);
             }
-            
-            csv_ptr += written;
-            remaining_space -= written;
+            break;
+        case ROOM_LEAVE:
+            leaderboard_remove(leaderboard, request->player);
+            remove_player(players_array, request->player);
+            break;
+        case ROOM_ADVANCE: {
+            RoundSnapshot *round = atomic_load(&current_round);
+            atomic_store(&simulated_now_ms, round->deadline_ms);
+            run_round_transition(round->state);
+            break;
         }
+    }
+    sem_post(&request->done);
+}
 
-        // Adding null terminator instead of last comma if we added any entries.
-        if (csv_result[0] != '\0') {
-            *(csv_ptr - 1) = '\0';
-        }
+// Simulation only: jumping the virtual clock to the end of the current phase and running its transition.
+void advance_round() {
+    RoomRequest request = {0};
+    room_request(ROOM_ADVANCE, &request);
+}
+
+// Publishing the waiting round that comes before the first game.
+static void publish_pre_game_round() {
+    int pre_game_duration = waiting_duration < PRE_GAME_DURATION ? waiting_duration : PRE_GAME_DURATION;
+    LOG_INFO(BOLD GREEN "Get ready for the game! %d seconds of waiting... feel free to register or ask for help" RESET, pre_game_duration);
+    round_slots[0].state = WAITING_STATE;
+    round_slots[0].deadline_ms = round_clock_ms() + pre_game_duration * 1000LL; // Giving a small pre-game time so users can register and get ready.
+}
 
-        printf("Final results: %s\n", csv_result);
+// Loading configuration from a file.
+Error load_config(const char *filename, Config *config) {
+    FILE *file;
+    SYSCN(file, fopen(filename, "r"), "Failed to open config file");
 
-        is_csv_results_scoreboard_ready = true;
-        ret = pthread_cond_broadcast(&csv_results_condition);
-        if (ret != 0) {
-            fprintf(stderr, "Broadcast failed: %s\n", strerror(ret));
+    // Defaults for the optional keys.
+    config->max_players = MAX_PLAYERS;
+    config->validation_workers = DEFAULT_VALIDATION_WORKERS;
+    config->dictionary_cache_entries = DEFAULT_DICTIONARY_CACHE_ENTRIES;
+    config->leaderboard_top_k = DEFAULT_LEADERBOARD_TOP_K;
+    config->leaderboard_push_ms = DEFAULT_LEADERBOARD_PUSH_MS;
+    config->log_level = DEFAULT_LOG_LEVEL;
+    config->admin_socket[0] = '\0';
+    config->flight_recorder_file[0] = '\0';
+
+    char line[MAX_CONF_LINE_LENGTH];
+    while (fgets(line, sizeof(line), file)) {
+        trim_newline(line);
+        char *key = strtok(line, "=");
+        char *value = strtok(NULL, "=");
+
+        if (key == NULL) {
+            continue; // Skipping empty lines.
         }
 
-        ret = pthread_mutex_unlock(&state_mutex);
-        if (ret != 0) {
-            fprintf(stderr, "Failed to unlock mutex: %s\n", strerror(ret));
+        int *positive_value = NULL;
+        if (strcmp(key, "max_players") == 0) {
+            positive_value = &config->max_players;
+        } else if (strcmp(key, "leaderboard_top_k") == 0) {
+            positive_value = &config->leaderboard_top_k;
+        } else if (strcmp(key, "leaderboard_push_ms") == 0) {
+            positive_value = &config->leaderboard_push_ms;
+        } else if (strcmp(key, "validation_workers") == 0) {
+            positive_value = &config->validation_workers;
+        } else if (strcmp(key, "dictionary_cache_entries") == 0) {
+            positive_value = &config->dictionary_cache_entries;
+        }
+
+        if (positive_value != NULL) {
+            int parsed = value != NULL ? atoi(value) : 0;
+            if (parsed <= 0) {
+                fclose(file);
+                return CONFIG_ERROR_VALUE;
+            }
+            *positive_value = parsed;
+        } else if (strcmp(key, "log_level") == 0) {
+            if (value == NULL || !parse_log_level(value, &config->log_level)) {
+                fclose(file);
+                return CONFIG_ERROR_VALUE;
+            }
+        } else if (strcmp(key, "admin_socket") == 0 || strcmp(key, "flight_recorder_file") == 0) {
+            char *path = strcmp(key, "admin_socket") == 0 ? config->admin_socket : config->flight_recorder_file;
+            if (value == NULL || strlen(value) >= MAX_SOCKET_PATH_LENGTH) {
+                fclose(file);
+                return CONFIG_ERROR_VALUE;
+            }
+            strcpy(path, value);
+        } else if (strcmp(key, "socket_backlog") == 0) {
+            if (value != NULL && strlen(value) > 0 && value[0] != '-')
+                config->backlog = atoi(value);
+            else {
+                fclose(file);
+                return CONFIG_ERROR_BACKLOG;
+            }
         }
     }
 
-    return NULL;
+    fclose(file);
+
+    // The standings are pushed as one frame, more players than fit in it can't be listed.
+    if (config->leaderboard_top_k > MAX_LEADERBOARD_TOP_K) {
+        config->leaderboard_top_k = MAX_LEADERBOARD_TOP_K;
+    }
+    return SUCCESS;
 }
 
 // Initializing the server and starting to listen for connections.
-void init_server(char *server_name, int server_port, unsigned int randomization_seed, int game_length, char *matrix_file, char *dictionary_file) {
+void init_server(char *server_name, int server_port, unsigned int randomization_seed, int game_length, int waiting_length, char *matrix_file, char *dictionary_file, const SimulationOptions *simulation) {
     int server_socket_fd, client_fd, last_ret_value;
     struct sockaddr_in server_addr, client_addr;
     socklen_t client_addr_len;
     match_duration = game_length; // Setting game duration.
+    waiting_duration = waiting_length;
     matrix_file_global = matrix_file;
 
     // Loading configuration file.
-    Config config;
     Error err = load_config("config.txt", &config);
     handle_error(err);
+
+    // From here on log lines are written by a background thread.
+    log_init(config.log_level, STDOUT_FILENO);
+
+    // The shared state comes first, the metrics can be scraped as soon as the admin socket is up.
+    players_array = create_player_registry(config.max_players);
+    round_arena = arena_create(ARENA_CHUNK_SIZE);
+    leaderboard = create_leaderboard(config.leaderboard_top_k);
+
+    // Every connection has at most one word queued at a time.
+    validation_pool = create_validation_pool(config.validation_workers, config.max_players, validate_word, forward_to_room);
+    dictionary_cache = verdict_cache_create(config.dictionary_cache_entries);
+
+    // Exposing the metrics on a local admin socket.
+    init_metrics();
+    broadcast_sender = create_broadcast_sender(slow_clients_disconnected);
+    if (config.admin_socket[0] == '\0') {
+        snprintf(config.admin_socket, sizeof(config.admin_socket), "/tmp/paroliere_srv_%d.sock", server_port);
+    }
+    start_admin_server(config.admin_socket);
+
+    // Recording the latest events, dumped on SIGUSR1 or on a crash.
+    if (config.flight_recorder_file[0] == '\0') {
+        snprintf(config.flight_recorder_file, sizeof(config.flight_recorder_file), "/tmp/paroliere_srv_%d.flight", server_port);
+    }
+    flight_recorder_init(config.flight_recorder_file);
     
+    // A client closing its socket must not kill the server in the middle of a write.
+    signal(SIGPIPE, SIG_IGN);
+
     // Seeding the random number generator.
     srand(randomization_seed);
 
-    players_array = create_player_registry();
+    // Simulating: no sockets and no timer ticks, the scripted players drive the rounds.
+    if (simulation->rounds > 0) {
+        dictionary_root = init_dictionary(dictionary_file ? dictionary_file : "./data/dictionary_ita.txt");
+        simulated_clock = true;
+        publish_pre_game_round();
+        room = room_create(handle_room_event, next_round_tick_ms, round_tick);
+        if (!run_simulation(simulation, dictionary_root)) {
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
 
     // Setting up server name in server_addr->sin_addr.
     if (strcmp(server_name, "localhost") == 0) {
@@ -567,29 +1042,37 @@ void init_server(char *server_name, int server_port, unsigned int randomization_
     // Starting to listen for incoming connections.
     SYSC(last_ret_value, listen(server_socket_fd, config.backlog), "Listen failed");
 
-    printf("Server listening on port %d\n", server_port);
+    LOG_INFO("Server listening on port %d", server_port);
 
-    // Setting up signal handler and initial alarm.
-    signal(SIGALRM, alarm_handler);
-    printf(BOLD GREEN "\nGet ready for the game! %d seconds of waiting... feel free to register or ask for help\n" RESET, PRE_GAME_DURATION);
-    alarm(PRE_GAME_DURATION); // Giving a small pre-game time so users can register and get ready.
+    // Publishing the pre-game round and starting the room, which runs the round transitions on its deadlines.
+    publish_pre_game_round();
+    room = room_create(handle_room_event, next_round_tick_ms, round_tick);
 
-    // Starting the scoring thread.
-    pthread_t scorer_thread;
-    pthread_create(&scorer_thread, NULL, scorer_thread_loop, NULL);
+    // Starting the live leaderboard pushes.
+    pthread_t leaderboard_thread;
+    pthread_create(&leaderboard_thread, NULL, leaderboard_push_loop, NULL);
 
     // Main loop to accept incoming connections.
     while (1) {
         client_addr_len = sizeof(client_addr);
         SYSC(client_fd, accept(server_socket_fd, (struct sockaddr *)&client_addr, &client_addr_len), "Accepting client failed");
-        printf("Client %d connected\n", client_fd);
-
-        // Initializing the player.
-        Player* player;
-        player = malloc(sizeof(Player));
-        player->fd = client_fd;
-
-        pthread_create(&player->tid, NULL, handle_player, (void *)player);
+        LOG_DEBUG("Client %d connected", client_fd);
+        metric_add(connections_total, 1);
+        metric_add(clients_connected, 1);
+
+        // Every reply is one write, sent as it's ready even while the ones before it aren't acked yet:
+        // a client with several requests in flight would otherwise wait on its delayed acks.
+        int no_delay = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        // Initializing the player, it's owned by its connection thread.
+        Player* player = create_player(client_fd);
+        flight_record(FLIGHT_ACCEPT, player->connection_id, client_fd);
+
+        // Detached, nothing joins a connection thread. The id stays local: the thread may have freed the player already.
+        pthread_t connection_thread;
+        pthread_create(&connection_thread, NULL, handle_player, (void *)player);
+        pthread_detach(connection_thread);
     }
 
     // Closing the server socket.
@@ -0,0 +1,180 @@
+#include <fcntl.h>
+#include <ctype.h>
+
+#include "simulation.h"
+#include "server.h"
+#include "macros.h"
+#include "utils.h"
+#include "logger.h"
+#include "allocation_counter.h"
+
+#define SIM_MIN_WORD_LENGTH 4 // Shorter words are rejected by is_word_in_matrix
+#define SIM_GARBAGE_ONE_IN 4  // One submission in four is a random string, the rest walk the board
+
+// Following the letters of a cell down the trie, skipping the characters the trie skips.
+static TrieNode* follow_letters(TrieNode *node, const char *letters) {
+    for (; node && *letters; letters++) {
+        int index = tolower(*letters) - 'a';
+        if (index >= 0 && index < ALPHABET_SIZE) {
+            node = node->children[index];
+        }
+    }
+    return node;
+}
+
+// Walking the board from a random cell through horizontal and vertical neighbours, only towards
+// cells that keep the path a dictionary prefix. The longest word met on the way is kept, so most
+// walks produce a valid word and the rest produce a board path that isn't one.
+static void walk_board(Cell matrix[MATRIX_SIZE][MATRIX_SIZE], TrieNode *dictionary_root, unsigned int *rng, char *word) {
+    static const int moves[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+    bool used[MATRIX_SIZE][MATRIX_SIZE] = {{false}};
+    int row = rand_r(rng) % MATRIX_SIZE;
+    int col = rand_r(rng) % MATRIX_SIZE;
+    TrieNode *node = follow_letters(dictionary_root, matrix[row][col].letter);
+    int length = 0, word_length = 0;
+
+    while (1) {
+        used[row][col] = true;
+        for (const char *letter = matrix[row][col].letter; *letter; letter++) {
+            word[length++] = tolower(*letter);
+        }
+        if (node && node->end_of_word && length >= SIM_MIN_WORD_LENGTH) {
+            word_length = length;
+        }
+
+        // Collecting the neighbours that keep the path inside the dictionary.
+        int candidates[4][2], candidates_count = 0;
+        for (int i = 0; i < 4 && node; i++) {
+            int next_row = row + moves[i][0], next_col = col + moves[i][1];
+            if (next_row < 0 || next_row >= MATRIX_SIZE || next_col < 0 || next_col >= MATRIX_SIZE || used[next_row][next_col]) continue;
+            if (length + (int)strlen(matrix[next_row][next_col].letter) > MAX_WORD_LENGTH) continue;
+            if (!follow_letters(node, matrix[next_row][next_col].letter)) continue;
+            candidates[candidates_count][0] = next_row;
+            candidates[candidates_count][1] = next_col;
+            candidates_count++;
+        }
+        if (candidates_count == 0) break;
+
+        int pick = rand_r(rng) % candidates_count;
+        row = candidates[pick][0];
+        col = candidates[pick][1];
+        node = follow_letters(node, matrix[row][col].letter);
+    }
+
+    word[word_length > 0 ? word_length : length] = '\0';
+}
+
+// A random string of board length, almost never a word: it exercises the rejection path.
+static void random_word(unsigned int *rng, char *word) {
+    int length = SIM_MIN_WORD_LENGTH + rand_r(rng) % (MAX_WORD_LENGTH - SIM_MIN_WORD_LENGTH + 1);
+    for (int i = 0; i < length; i++) {
+        word[i] = 'a' + rand_r(rng) % 26;
+    }
+    word[length] = '\0';
+}
+
+// Registering the scripted players through the regular handler, their replies go to /dev/null.
+static Player** create_scripted_players(int count) {
+    int null_fd;
+    SYSC(null_fd, open("/dev/null", O_WRONLY), "Opening /dev/null failed");
+
+    Player **players = malloc(count * sizeof(Player*));
+    if (!players) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+
+    char username[MAX_USERNAME_LENGTH];
+    for (int i = 0; i < count; i++) {
+        players[i] = create_player(null_fd);
+        snprintf(username, sizeof(username), "sim%d", i % 1000000); // Unique below max_players
+        handle_registration(players[i], username);
+        if (!atomic_load(&players[i]->is_registered)) {
+            handle_error(MAX_PLAYERS_ERROR);
+        }
+    }
+    return players;
+}
+
+static void print_progress(int rounds, long long start_ns, long rss_start_kb) {
+    double elapsed = (monotonic_ns() - start_ns) / 1e9;
+    long rss_kb = get_rss_kb();
+    printf("sim: %d rounds in %.2f s, %.0f rounds/s, RSS %ld KB (%+ld KB)\n",
+           rounds, elapsed, rounds / elapsed, rss_kb, rss_kb - rss_start_kb);
+    fflush(stdout);
+}
+
+// Playing the given number of rounds as fast as they can be processed. Each round jumps the virtual
+// clock to the end of the waiting phase, lets every player submit its words, then jumps to the end
+// of the game phase, where the final scores are computed and sent as usual.
+// Failing when a word submission allocated on the heap after the first round: the steady-state path must not.
+bool run_simulation(const SimulationOptions *options, TrieNode *dictionary_root) {
+    // Five log lines per round would dominate the run, only warnings and errors are kept.
+    if (atomic_load(&log_level) < LOG_LEVEL_WARN) {
+        atomic_store(&log_level, LOG_LEVEL_WARN);
+    }
+
+    Player **players = create_scripted_players(options->players);
+    unsigned int rng = options->seed;
+    int report_interval = options->rounds >= 10 ? options->rounds / 10 : 1;
+    long submissions = 0, points = 0, steady_allocations = 0, steady_submissions = 0;
+    unsigned long checksum = 0; // Same seed, same options: same checksum
+    char word[MAX_WORD_LENGTH + 1];
+
+    printf("sim: %d rounds, %d players, %d words per player per round, seed %u\n",
+           options->rounds, options->players, options->words_per_player, options->seed);
+
+    long long start_ns = monotonic_ns();
+    long rss_start_kb = get_rss_kb();
+    for (int round_number = 1; round_number <= options->rounds; round_number++) {
+        advance_round(); // Waiting -> game, a new matrix is published
+
+        Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
+        RoundSnapshot *round = acquire_round();
+        memcpy(matrix, round->matrix, sizeof(matrix));
+        release_round(round);
+
+        // Interleaving the players like concurrent clients would, one word each at a time.
+        for (int w = 0; w < options->words_per_player; w++) {
+            for (int p = 0; p < options->players; p++) {
+                if (rand_r(&rng) % SIM_GARBAGE_ONE_IN == 0) {
+                    random_word(&rng, word);
+                } else {
+                    walk_board(matrix, dictionary_root, &rng, word);
+                }
+                long allocations_start = thread_allocations();
+                handle_word_submission(players[p], word);
+                submissions++;
+                if (round_number > 1) {
+                    steady_allocations += thread_allocations() - allocations_start;
+                    steady_submissions++;
+                }
+            }
+        }
+
+        advance_round(); // Game -> waiting, scores are kept until the next round starts
+
+        for (int p = 0; p < options->players; p++) {
+            int score = atomic_load(&players[p]->score);
+            points += score;
+            checksum = checksum * 31 + score;
+        }
+
+        if (round_number % report_interval == 0) {
+            print_progress(round_number, start_ns, rss_start_kb);
+        }
+    }
+
+    double elapsed = (monotonic_ns() - start_ns) / 1e9;
+    long rss_end_kb = get_rss_kb();
+    printf("sim: done, %d rounds in %.2f s: %.0f rounds/s, %.0f words/s, %ld points, checksum %lx\n",
+           options->rounds, elapsed, options->rounds / elapsed, submissions / elapsed, points, checksum);
+    printf("sim: RSS %ld KB -> %ld KB, %.1f KB per 1000 rounds\n",
+           rss_start_kb, rss_end_kb, (rss_end_kb - rss_start_kb) * 1000.0 / options->rounds);
+    if (ALLOCATION_COUNTING) {
+        printf("sim: %ld heap allocations in %ld word submissions after the first round\n", steady_allocations, steady_submissions);
+    } else {
+        printf("sim: heap allocations not counted, make sim builds with -DALLOCATION_COUNTING=1\n");
+    }
+    fflush(stdout);
+    return steady_allocations == 0;
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #include <macros.h>
 #include "utils.h"
@@ -47,3 +48,55 @@ float parse_position_float(const char *str) {
 char get_random_letter() {
     return ITALIAN_ALPHABET[rand() % ITALIAN_ALPHABET_SIZE];
 }
+
+// Reading the resident set size of the process from /proc, -1 if it's not available
+long get_rss_kb() {
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (!file) {
+        return -1;
+    }
+
+    long total_pages, resident_pages;
+    int read = fscanf(file, "%ld %ld", &total_pages, &resident_pages);
+    fclose(file);
+    if (read != 2) {
+        return -1;
+    }
+
+    return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Milliseconds from the monotonic clock, not affected by changes to the system time
+long long monotonic_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+long long monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Writing the whole buffer, a socket may accept it in several pieces
+bool write_all(int fd, const char *buffer, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, buffer, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buffer += written;
+        size -= written;
+    }
+    return true;
+}
+
+void sleep_until_ms(long long deadline_ms) {
+    struct timespec deadline = {
+        .tv_sec = deadline_ms / 1000,
+        .tv_nsec = (deadline_ms % 1000) * 1000000
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "validation_pool.h"
+#include "macros.h"
+#include "utils.h"
+#include "allocation_counter.h"
+
+static void* validation_worker_loop(void *arg) {
+    ValidationPool *pool = (ValidationPool *)arg;
+    while (1) {
+        while (sem_wait(&pool->pending) == -1 && errno == EINTR);
+
+        // The post follows a complete push, but an earlier slot may still be in the middle of one
+        void *item;
+        while (!mpmc_pop(pool->queue, &item)) {
+            sched_yield();
+        }
+
+        ValidationJob *job = (ValidationJob *)item;
+        atomic_fetch_add(&pool->busy_workers, 1);
+        job->started_ns = monotonic_ns();
+        long allocations_start = thread_allocations();
+        bool completed = pool->validate(job);
+        job->allocations = thread_allocations() - allocations_start;
+        atomic_fetch_sub(&pool->busy_workers, 1);
+        // A forwarded job may be completed, and gone, as soon as it's handed on: it's not touched after.
+        if (completed) {
+            validation_job_done(pool, job);
+        } else {
+            pool->forward(job);
+        }
+    }
+    return NULL;
+}
+
+// Starting the workers, capacity should cover every connection since each one has at most one job queued
+ValidationPool* create_validation_pool(int workers, size_t capacity, bool (*validate)(ValidationJob *job), void (*forward)(ValidationJob *job)) {
+    ValidationPool *pool = malloc(sizeof(ValidationPool));
+    if (!pool) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    pool->queue = mpmc_create(capacity);
+    sem_init(&pool->pending, 0, 0);
+    atomic_init(&pool->busy_workers, 0);
+    atomic_init(&pool->replies_pending, 0);
+    pool->workers = workers;
+    pool->validate = validate;
+    pool->forward = forward;
+
+    for (int i = 0; i < workers; i++) {
+        pthread_t worker;
+        pthread_create(&worker, NULL, validation_worker_loop, pool);
+        pthread_detach(worker);
+    }
+    return pool;
+}
+
+// Queueing the job and waiting for a worker to validate it, the caller then sends the reply
+// and calls validation_reply_sent. With a full queue the job is validated on the calling thread.
+void validation_pool_run(ValidationPool *pool, ValidationJob *job) {
+    sem_init(&job->done, 0, 0);
+    job->enqueued_ns = monotonic_ns();
+
+    if (mpmc_push(pool->queue, job)) {
+        sem_post(&pool->pending);
+        while (sem_wait(&job->done) == -1 && errno == EINTR);
+    } else {
+        job->started_ns = job->enqueued_ns;
+        job->allocations = 0; // Already counted on this thread
+        if (pool->validate(job)) {
+            atomic_fetch_add(&pool->replies_pending, 1);
+        } else {
+            pool->forward(job);
+            while (sem_wait(&job->done) == -1 && errno == EINTR);
+        }
+    }
+
+    sem_destroy(&job->done);
+}
+
+// Completing a job, its connection thread wakes up and sends the reply
+void validation_job_done(ValidationPool *pool, ValidationJob *job) {
+    atomic_fetch_add(&pool->replies_pending, 1);
+    sem_post(&job->done);
+}
+
+void validation_reply_sent(ValidationPool *pool) {
+    atomic_fetch_sub(&pool->replies_pending, 1);
+}
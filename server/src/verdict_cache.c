@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "verdict_cache.h"
+#include "macros.h"
+#include "utils.h"
+
+// The capacity is rounded up to a power of two sets, so a hash maps to its set with a mask
+VerdictCache* verdict_cache_create(size_t capacity) {
+    size_t sets = 1;
+    while (sets * VERDICT_CACHE_WAYS < capacity) sets *= 2;
+
+    VerdictCache *cache = malloc(sizeof(VerdictCache));
+    if (!cache) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    cache->slots = aligned_alloc(CACHE_LINE_SIZE, sets * VERDICT_CACHE_WAYS * sizeof(VerdictSlot));
+    if (!cache->slots) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+    for (size_t i = 0; i < sets * VERDICT_CACHE_WAYS; i++) {
+        atomic_init(&cache->slots[i].sequence, 0);
+        atomic_init(&cache->slots[i].in_dictionary, false);
+        for (int k = 0; k < VERDICT_CACHE_KEY_WORDS; k++) {
+            atomic_init(&cache->slots[i].key[k], 0);
+        }
+    }
+    cache->set_mask = sets - 1;
+    atomic_init(&cache->entries, 0);
+    atomic_init(&cache->evictions, 0);
+    return cache;
+}
+
+// Packing the word in the key, false when it's too long to be cached
+static bool make_key(const char *word, unsigned long long key[VERDICT_CACHE_KEY_WORDS]) {
+    size_t length = strlen(word);
+    if (length > sizeof(unsigned long long) * VERDICT_CACHE_KEY_WORDS) {
+        return false;
+    }
+    memset(key, 0, sizeof(unsigned long long) * VERDICT_CACHE_KEY_WORDS);
+    memcpy(key, word, length);
+    return true;
+}
+
+static unsigned long long hash_key(const unsigned long long key[VERDICT_CACHE_KEY_WORDS]) {
+    unsigned long long hash = 0;
+    for (int k = 0; k < VERDICT_CACHE_KEY_WORDS; k++) {
+        hash = (hash ^ key[k]) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+static VerdictSlot* set_of(VerdictCache *cache, unsigned long long hash) {
+    return &cache->slots[(hash & cache->set_mask) * VERDICT_CACHE_WAYS];
+}
+
+// Reading a slot as a whole, false when it's empty, being written or changed while read
+static bool read_slot(VerdictSlot *slot, unsigned long long key[VERDICT_CACHE_KEY_WORDS], bool *in_dictionary) {
+    unsigned long sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence == 0 || (sequence & 1)) {
+        return false;
+    }
+    for (int k = 0; k < VERDICT_CACHE_KEY_WORDS; k++) {
+        key[k] = atomic_load_explicit(&slot->key[k], memory_order_relaxed);
+    }
+    *in_dictionary = atomic_load_explicit(&slot->in_dictionary, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->sequence, memory_order_relaxed) == sequence;
+}
+
+bool verdict_cache_lookup(VerdictCache *cache, const char *word, bool *in_dictionary) {
+    unsigned long long key[VERDICT_CACHE_KEY_WORDS];
+    if (!make_key(word, key)) {
+        return false;
+    }
+
+    VerdictSlot *set = set_of(cache, hash_key(key));
+    for (int way = 0; way < VERDICT_CACHE_WAYS; way++) {
+        unsigned long long slot_key[VERDICT_CACHE_KEY_WORDS];
+        bool slot_verdict;
+        if (read_slot(&set[way], slot_key, &slot_verdict) && memcmp(slot_key, key, sizeof(key)) == 0) {
+            *in_dictionary = slot_verdict;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Filling an empty way of the word's set, or replacing the way its hash picks when the set is full
+void verdict_cache_insert(VerdictCache *cache, const char *word, bool in_dictionary) {
+    unsigned long long key[VERDICT_CACHE_KEY_WORDS];
+    if (!make_key(word, key)) {
+        return;
+    }
+
+    unsigned long long hash = hash_key(key);
+    VerdictSlot *set = set_of(cache, hash);
+    VerdictSlot *slot = &set[(hash >> 32) % VERDICT_CACHE_WAYS];
+    bool found_empty = false;
+    for (int way = 0; way < VERDICT_CACHE_WAYS; way++) {
+        unsigned long long slot_key[VERDICT_CACHE_KEY_WORDS];
+        bool slot_verdict;
+        if (read_slot(&set[way], slot_key, &slot_verdict) && memcmp(slot_key, key, sizeof(key)) == 0) {
+            return; // Another worker missed the same word and cached it first
+        }
+        if (!found_empty && atomic_load_explicit(&set[way].sequence, memory_order_relaxed) == 0) {
+            slot = &set[way];
+            found_empty = true;
+        }
+    }
+
+    // Claiming the slot, another writer already on it wins and this verdict is just not cached.
+    unsigned long sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    if ((sequence & 1) || !atomic_compare_exchange_strong_explicit(&slot->sequence, &sequence, sequence + 1,
+                                                                   memory_order_relaxed, memory_order_relaxed)) {
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+
+    for (int k = 0; k < VERDICT_CACHE_KEY_WORDS; k++) {
+        atomic_store_explicit(&slot->key[k], key[k], memory_order_relaxed);
+    }
+    atomic_store_explicit(&slot->in_dictionary, in_dictionary, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+
+    if (sequence == 0) {
+        atomic_fetch_add_explicit(&cache->entries, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&cache->evictions, 1, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Comparing the build profiles (debug, release, lto, pgo) on the simulation:
+# dictionary load time, rounds/s, word submissions/s and executable size, median of RUNS runs each.
+# Usage (from the server directory): make profile_report, or tools/profile_report.sh [runs]
+set -e
+
+RUNS=${1:-5}
+OBJECTS_DIRECTORY=${OBJECTS_DIRECTORY:-objects}
+EXECUTABLES_DIRECTORY=${EXECUTABLES_DIRECTORY:-executables}
+# A different seed than the PGO training run, so the profile isn't judged on the rounds it was trained on
+SIMULATION="localhost 8998 --sim 2000 --sim-players 64 --seed 42"
+
+median() {
+    sort -n | awk '{ values[NR] = $1 } END { print values[int((NR + 1) / 2)] }'
+}
+
+echo "Building the profiles..."
+for profile in debug release lto pgo; do
+    target=$profile
+    [ "$profile" = debug ] && target=all
+    make -s $target OBJECTS_DIRECTORY="$OBJECTS_DIRECTORY" EXECUTABLES_DIRECTORY="$EXECUTABLES_DIRECTORY" > /dev/null
+done
+
+printf "%-8s %14s %10s %12s %10s\n" profile dict_load_ms rounds/s words/s size_kb
+for profile in debug release lto pgo; do
+    executable=$EXECUTABLES_DIRECTORY/$profile/paroliere_srv
+    [ "$profile" = debug ] && executable=$EXECUTABLES_DIRECTORY/paroliere_srv
+
+    results=$(mktemp)
+    run=0
+    while [ $run -lt "$RUNS" ]; do
+        # "Dictionary loaded: N words in T ms" and "sim: done, R rounds in S s: X rounds/s, Y words/s, ..."
+        $executable $SIMULATION 2>&1 | awk '
+            /Dictionary loaded:/ { for (i = 1; i <= NF; i++) if ($i == "ms") load = $(i - 1) }
+            /sim: done/ { for (i = 1; i <= NF; i++) { if ($i == "rounds/s,") rounds = $(i - 1); if ($i == "words/s,") words = $(i - 1) } }
+            END { print load, rounds, words }' >> "$results"
+        run=$((run + 1))
+    done
+
+    load=$(cut -d' ' -f1 "$results" | median)
+    rounds=$(cut -d' ' -f2 "$results" | median)
+    words=$(cut -d' ' -f3 "$results" | median)
+    size=$(( $(stat -c %s "$executable") / 1024 ))
+    printf "%-8s %14s %10s %12s %10s\n" "$profile" "$load" "$rounds" "$words" "$size"
+    rm -f "$results"
+done
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "server.h"
+#include "matrix_handler.h"
+#include "macros.h"
+#include "utils.h"
+
+// Concurrent stress driver, meant to run against the ThreadSanitizer build (make stress).
+// Every client thread connects, registers, pipelines words and matrix requests, then leaves, over and over:
+// sometimes after reading every reply, sometimes with replies still on the way. Words are picked among the ones
+// traceable on the last matrix received, so they also reach the room, with a share of random letters rejected earlier.
+// Fails when a connection can't be opened or a reply doesn't come back in time, the signs of a stuck server,
+// and when no word was scored at all.
+
+#define STRESS_USAGE "Usage: ./executables/tsan/paroliere_stress server_name server_port [--clients n] [--duration seconds] [--diz dictionary_file] [--seed n]\n"
+
+#define STRESS_REPLY_TIMEOUT_S 5
+#define STRESS_MAX_PIPELINE 16
+#define STRESS_GARBAGE_ONE_IN 5
+#define STRESS_ABANDON_ONE_IN 4    // Sessions closed without reading their last replies
+
+typedef struct {
+    char **words;
+    size_t size;
+} WordList;
+
+// The words traceable on the current board. All the clients play the same round, the first one to see a new
+// matrix rebuilds the list for everyone.
+typedef struct {
+    pthread_mutex_t mutex;
+    Cell matrix[MATRIX_SIZE][MATRIX_SIZE];
+    size_t *words; // Indices in the WordList
+    size_t size;
+    bool built;
+} BoardWords;
+
+typedef struct {
+    struct sockaddr_in server_addr;
+    long long deadline_ms;
+    const WordList *dictionary;
+} StressOptions;
+
+typedef struct {
+    int id;
+    unsigned int rng;
+    const StressOptions *options;
+    int fd;
+    char buffer[2 * MAX_BUFFER_SIZE];
+    size_t buffered;
+    char pending[STRESS_MAX_PIPELINE]; // Types of the requests waiting for their reply, oldest first
+    int pending_size;
+    bool got_body;                     // The head request got its matrix, its time frame or its K can follow
+    bool has_board;
+    Cell board[MATRIX_SIZE][MATRIX_SIZE];
+} StressClient;
+
+static BoardWords board_words = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+static atomic_long sessions, requests_sent, replies, errors, points, pushes, failures;
+
+// Loading every word the server could accept, stress.sh passes the reduced dictionary the server loaded
+static WordList load_words(const char *filename) {
+    WordList list = {0};
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        handle_error(FILE_OPEN_ERROR);
+    }
+
+    size_t capacity = 1024;
+    char line[256];
+    list.words = malloc(capacity * sizeof(char *));
+    while (list.words && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        size_t length = strlen(line);
+        if (length < 4 || length > MAX_WORD_LENGTH) continue;
+
+        if (list.size == capacity) {
+            capacity *= 2;
+            list.words = realloc(list.words, capacity * sizeof(char *));
+            if (!list.words) break;
+        }
+        list.words[list.size++] = strdup(line);
+    }
+    fclose(file);
+
+    if (!list.words || list.size == 0) {
+        handle_error(FILE_SIZE_ERROR);
+    }
+    return list;
+}
+
+// A word for the client's board, copied into word: traceable if the board has any, random letters otherwise
+static void pick_word(StressClient *client, char *word) {
+    if (client->has_board && rand_r(&client->rng) % STRESS_GARBAGE_ONE_IN != 0) {
+        const WordList *dictionary = client->options->dictionary;
+        pthread_mutex_lock(&board_words.mutex);
+        if (!board_words.built || memcmp(board_words.matrix, client->board, MATRIX_BYTES) != 0) {
+            memcpy(board_words.matrix, client->board, MATRIX_BYTES);
+            board_words.size = 0;
+            for (size_t i = 0; i < dictionary->size; i++) {
+                if (is_word_in_matrix(client->board, dictionary->words[i])) {
+                    board_words.words[board_words.size++] = i;
+                }
+            }
+            board_words.built = true;
+        }
+        bool found = board_words.size > 0;
+        if (found) {
+            strcpy(word, dictionary->words[board_words.words[rand_r(&client->rng) % board_words.size]]);
+        }
+        pthread_mutex_unlock(&board_words.mutex);
+        if (found) return;
+    }
+
+    int length = 4 + rand_r(&client->rng) % 6;
+    for (int i = 0; i < length; i++) {
+        word[i] = 'a' + rand_r(&client->rng) % 26;
+    }
+    word[length] = '\0';
+}
+
+static bool send_request(StressClient *client, char type, const char *content) {
+    char buffer[MAX_BUFFER_SIZE];
+    Message message = { .type = type, .size = strlen(content), .data = (char *)content };
+    int size = serialize_message(&message, buffer, sizeof(buffer));
+    if (size < 0 || !write_all(client->fd, buffer, size)) {
+        return false;
+    }
+    client->pending[client->pending_size++] = type;
+    atomic_fetch_add(&requests_sent, 1);
+    return true;
+}
+
+// Reading the next frame, false on a timeout, a closed connection or a malformed frame
+static bool read_frame(StressClient *client, Message *message) {
+    while (1) {
+        if (client->buffered >= sizeof(int)) {
+            int frame_length;
+            memcpy(&frame_length, client->buffer, sizeof(int));
+            if (frame_length <= 0 || frame_length > (int)(sizeof(client->buffer) - sizeof(int))) {
+                return false;
+            }
+            if (client->buffered >= sizeof(int) + frame_length) {
+                return deserialize_message(client->buffer + sizeof(int), frame_length, message) > 0;
+            }
+        }
+
+        ssize_t bytes_read = read(client->fd, client->buffer + client->buffered, sizeof(client->buffer) - client->buffered);
+        if (bytes_read == -1 && errno == EINTR) continue;
+        if (bytes_read <= 0) return false;
+        client->buffered += bytes_read;
+    }
+}
+
+// Dropping the frame read_frame returned last
+static void consume_frame(StressClient *client) {
+    int frame_length;
+    memcpy(&frame_length, client->buffer, sizeof(int));
+    size_t size = sizeof(int) + frame_length;
+    memmove(client->buffer, client->buffer + size, client->buffered - size);
+    client->buffered -= size;
+}
+
+// Whether the frame belongs to the reply of the oldest pending request, replies come back in request order.
+// registra_utente: [matrix] time left, then K or E. matrice: matrix or E, then time left. parola: P or E.
+static bool belongs_to_reply(StressClient *client, char type, bool *last) {
+    bool time_frame = type == MSG_TEMPO_PARTITA || type == MSG_TEMPO_ATTESA;
+    *last = false;
+    switch (client->pending[0]) {
+        case MSG_REGISTRA_UTENTE:
+            *last = type == MSG_OK || type == MSG_ERR;
+            return *last || type == MSG_MATRICE || time_frame;
+        case MSG_MATRICE:
+            if (!client->got_body) {
+                client->got_body = type == MSG_MATRICE || type == MSG_ERR;
+                return client->got_body;
+            }
+            *last = time_frame;
+            return *last;
+        default:
+            *last = type == MSG_PUNTI_PAROLA || type == MSG_ERR;
+            return *last;
+    }
+}
+
+// Reading frames until every pending request got its reply, anything else is a push:
+// matrix and time left at round start, standings, final scores.
+static bool await_replies(StressClient *client) {
+    while (client->pending_size > 0) {
+        Message message;
+        if (!read_frame(client, &message)) {
+            return false;
+        }
+
+        if (message.type == MSG_MATRICE && message.size == MATRIX_BYTES) {
+            memcpy(client->board, message.data, MATRIX_BYTES);
+            client->has_board = true;
+        }
+
+        bool last;
+        if (!belongs_to_reply(client, message.type, &last)) {
+            atomic_fetch_add(&pushes, 1);
+        } else if (last) {
+            atomic_fetch_add(&replies, 1);
+            if (message.type == MSG_ERR) {
+                atomic_fetch_add(&errors, 1);
+            } else if (message.type == MSG_PUNTI_PAROLA) {
+                char value[16]; // The payload isn't NUL terminated
+                snprintf(value, sizeof(value), "%.*s", message.size, message.data);
+                atomic_fetch_add(&points, atol(value));
+            }
+            memmove(client->pending, client->pending + 1, --client->pending_size);
+            client->got_body = false;
+        }
+        consume_frame(client);
+    }
+    return true;
+}
+
+// One connection: registering, a few pipelined bursts of words and matrix requests, then leaving
+static bool run_session(StressClient *client, int generation) {
+    SYSC(client->fd, socket(AF_INET, SOCK_STREAM, 0), "Stress socket creation failed");
+    struct timeval timeout = { .tv_sec = STRESS_REPLY_TIMEOUT_S };
+    setsockopt(client->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    int flag = 1;
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    client->buffered = 0;
+    client->pending_size = 0;
+    client->got_body = false;
+
+    bool ok = connect(client->fd, (struct sockaddr *)&client->options->server_addr, sizeof(client->options->server_addr)) == 0;
+    char username[MAX_USERNAME_LENGTH];
+    // Fits the 9 characters of a username, a generation coming back after 10000 sessions has long left
+    snprintf(username, sizeof(username), "s%u_%u", (unsigned int)client->id % 1000, (unsigned int)generation % 10000);
+    ok = ok && send_request(client, MSG_REGISTRA_UTENTE, username) && await_replies(client);
+
+    int bursts = 1 + rand_r(&client->rng) % 4;
+    for (int burst = 0; ok && burst < bursts; burst++) {
+        int pipelined = 1 + rand_r(&client->rng) % STRESS_MAX_PIPELINE;
+        for (int i = 0; ok && i < pipelined; i++) {
+            if (rand_r(&client->rng) % 8 == 0) {
+                ok = send_request(client, MSG_MATRICE, "");
+            } else {
+                char word[MAX_WORD_LENGTH + 1];
+                pick_word(client, word);
+                ok = send_request(client, MSG_PAROLA, word);
+            }
+        }
+
+        // The last burst is sometimes left unread: the server sees a disconnection with requests in flight.
+        bool abandon = burst == bursts - 1 && rand_r(&client->rng) % STRESS_ABANDON_ONE_IN == 0;
+        ok = ok && (abandon || await_replies(client));
+    }
+
+    close(client->fd);
+    atomic_fetch_add(&sessions, 1);
+    return ok;
+}
+
+static void* client_thread(void *arg) {
+    StressClient *client = (StressClient *)arg;
+    for (int generation = 0; monotonic_ms() < client->options->deadline_ms; generation++) {
+        // One failure is enough to fail the run, the client stops there instead of retrying a stuck server.
+        if (!run_session(client, generation)) {
+            atomic_fetch_add(&failures, 1);
+            fprintf(stderr, "Client %d: session %d failed: %s\n", client->id, generation, strerror(errno));
+            break;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int clients = 32;
+    double duration_s = 30;
+    const char *dictionary_file = "./data/dictionary_ita.txt";
+    unsigned int seed = 1;
+
+    static struct option long_opts[] = {
+        {"clients",  required_argument, NULL, 'c'},
+        {"duration", required_argument, NULL, 'd'},
+        {"diz",      required_argument, NULL, 'z'},
+        {"seed",     required_argument, NULL, 's'},
+        {0, 0, 0, 0}
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "c:d:z:s:", long_opts, NULL)) != -1) {
+        switch (option) {
+            case 'c': clients = atoi(optarg); break;
+            case 'd': duration_s = atof(optarg); break;
+            case 'z': dictionary_file = optarg; break;
+            case 's': seed = (unsigned int)atoi(optarg); break;
+            default:
+                fprintf(stderr, STRESS_USAGE);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (argc - optind != 2) {
+        fprintf(stderr, STRESS_USAGE);
+        exit(EXIT_FAILURE);
+    }
+    if (clients <= 0 || clients > 1000 || duration_s <= 0) {
+        handle_error(NEGATIVE_PARAM_ERROR);
+    }
+    const char *server_name = argv[optind], *server_port = argv[optind + 1];
+
+    WordList dictionary = load_words(dictionary_file);
+    board_words.words = malloc(dictionary.size * sizeof(size_t));
+    StressClient *threads_data = calloc(clients, sizeof(StressClient));
+    pthread_t *threads = malloc(clients * sizeof(pthread_t));
+    if (!board_words.words || !threads_data || !threads) {
+        handle_error(MEMORY_ALLOCATION_ERROR);
+    }
+
+    StressOptions options = { .deadline_ms = monotonic_ms() + (long long)(duration_s * 1000), .dictionary = &dictionary };
+    options.server_addr.sin_family = AF_INET;
+    options.server_addr.sin_port = htons(atoi(server_port));
+    if (inet_pton(AF_INET, strcmp(server_name, "localhost") == 0 ? "127.0.0.1" : server_name, &options.server_addr.sin_addr) <= 0) {
+        handle_error(SERVER_NAME_ERROR);
+    }
+
+    printf("Stress: %d clients for %.0f s against %s:%s, %zu candidate words\n", clients, duration_s, server_name, server_port, dictionary.size);
+    for (int i = 0; i < clients; i++) {
+        threads_data[i] = (StressClient){ .id = i, .rng = seed + i, .options = &options };
+        if (pthread_create(&threads[i], NULL, client_thread, &threads_data[i]) != 0) {
+            fprintf(stderr, "Failed to start client %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    printf("Stress: %ld sessions, %ld requests, %ld replies (%ld errors, %ld points), %ld pushes, %ld failed sessions\n",
+           atomic_load(&sessions), atomic_load(&requests_sent), atomic_load(&replies), atomic_load(&errors),
+           atomic_load(&points), atomic_load(&pushes), atomic_load(&failures));
+
+    // Without a scored word the room's scoring and the leaderboard never ran concurrently with the rest
+    bool scored = atomic_load(&points) > 0;
+    if (!scored) {
+        fprintf(stderr, "Stress: no word was scored, the run never reached a game\n");
+    }
+
+    for (size_t i = 0; i < dictionary.size; i++) free(dictionary.words[i]);
+    free(dictionary.words);
+    free(board_words.words);
+    free(threads_data);
+    free(threads);
+    return atomic_load(&failures) == 0 && scored ? EXIT_SUCCESS : EXIT_FAILURE;
+}
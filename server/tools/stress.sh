@@ -0,0 +1,44 @@
+#!/bin/sh
+# Stress run under ThreadSanitizer: the tsan server with 6 s games and 1 s breaks, and the stress driver's clients
+# registering, submitting words and leaving across the round transitions. Most of the run is spent in games, so words
+# are scored while players join and leave. Fails on any race report, on a session whose replies didn't come back
+# in time, on a run that scored no word, or if the server died.
+# Usage (from the server directory): make stress, or tools/stress.sh [seconds] [clients]
+set -e
+
+DURATION=${1:-30} # About four games and their transitions
+CLIENTS=${2:-32}
+PORT=8996
+EXECUTABLES_DIRECTORY=${EXECUTABLES_DIRECTORY:-executables}
+SERVER_LOG=$(mktemp)
+DICTIONARY=$(mktemp)
+
+# One word in 16: TSan shadows every trie node, the full dictionary would take most of the memory of a small machine.
+awk 'NR % 16 == 1' data/dictionary_ita.txt > "$DICTIONARY"
+
+TSAN_OPTIONS="second_deadlock_stack=1" $EXECUTABLES_DIRECTORY/tsan/paroliere_srv localhost $PORT --durata 0.1 --attesa 1 --diz "$DICTIONARY" > "$SERVER_LOG" 2>&1 &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null; rm -f "$SERVER_LOG" "$DICTIONARY"' EXIT
+
+# The server listens once its dictionary is loaded.
+tries=0
+until grep -q "listening" "$SERVER_LOG"; do
+    tries=$((tries + 1))
+    [ $tries -le 300 ] || { echo "The tsan server didn't start" >&2; cat "$SERVER_LOG" >&2; exit 1; }
+    sleep 0.1
+done
+
+status=0
+$EXECUTABLES_DIRECTORY/tsan/paroliere_stress localhost $PORT --clients "$CLIENTS" --duration "$DURATION" --diz "$DICTIONARY" || status=1
+
+if ! kill -0 $SERVER_PID 2>/dev/null; then
+    echo "The server died during the stress run" >&2
+    status=1
+fi
+if grep -q "WARNING: ThreadSanitizer" "$SERVER_LOG"; then
+    echo "ThreadSanitizer reports from the server:" >&2
+    sed -n '/WARNING: ThreadSanitizer/,/^==================$/p' "$SERVER_LOG" >&2
+    status=1
+fi
+[ $status -eq 0 ] && echo "Stress: no race reported"
+exit $status